@@ -0,0 +1,422 @@
+// Build and run:
+//   g++ -std=c++20 -O2 benchmarks.cpp big_integer.cpp big_float.cpp
+//     big_integer_batch.cpp big_integer_ntt.cpp big_integer_mmap.cpp
+//     -lbenchmark -pthread
+//   ./a.out --benchmark_out=before.json --benchmark_out_format=json
+// Two runs are compared with compare.py from the google-benchmark tools.
+//
+// The suite sweeps operand sizes in limbs: linear operations up to 2^20
+// limbs, quadratic ones (multiplication, division, decimal conversion)
+// up to 2^14. The third argument is the sign mask: bit 0 makes the left
+// operand negative, bit 1 the right one. Every suite benchmark reports
+// time per limb of the left operand and heap allocations per iteration.
+
+#include "benchmark/benchmark.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "big_float.h"
+#include "big_integer.h"
+#include "big_integer_batch.h"
+#include "big_integer_expr.h"
+
+namespace {
+std::atomic<size_t> allocations {0};
+} // namespace
+
+// noinline keeps GCC from matching the inlined malloc and free against
+// new and delete expressions
+[[gnu::noinline]] void* operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+big_integer random_integer(size_t digits, std::mt19937& rng) {
+  std::string str(digits, '0');
+  for (char& c : str) {
+    c = static_cast<char>('0' + rng() % 10);
+  }
+  str[0] = static_cast<char>('1' + rng() % 9);
+  return big_integer(str);
+}
+
+std::vector<big_integer> coefficients(size_t count, size_t digits) {
+  std::mt19937 rng(count * 31 + digits);
+  std::vector<big_integer> res;
+  for (size_t i = 0; i < count; ++i) {
+    res.push_back(random_integer(digits, rng));
+  }
+  return res;
+}
+} // namespace
+
+static void polynomial_plain(benchmark::State& state) {
+  auto c = coefficients(state.range(0), 50);
+  big_integer x = c.back() - 12345;
+  for (auto _ : state) {
+    big_integer r = 0;
+    for (auto const& ci : c) {
+      r = r * x + ci;
+    }
+    benchmark::DoNotOptimize(r);
+  }
+}
+BENCHMARK(polynomial_plain)->Range(8, 256);
+
+static void polynomial_expr(benchmark::State& state) {
+  using bigint_expr::ref;
+  auto c = coefficients(state.range(0), 50);
+  big_integer x = c.back() - 12345;
+  for (auto _ : state) {
+    big_integer r = 0;
+    for (auto const& ci : c) {
+      bigint_expr::assign(r, ref(r) * ref(x) + ref(ci));
+    }
+    benchmark::DoNotOptimize(r);
+  }
+}
+BENCHMARK(polynomial_expr)->Range(8, 256);
+
+static void sum_chain_plain(benchmark::State& state) {
+  auto c = coefficients(4, state.range(0));
+  big_integer r;
+  for (auto _ : state) {
+    r = c[0] + c[1] - c[2] + c[3];
+    benchmark::DoNotOptimize(r);
+  }
+}
+BENCHMARK(sum_chain_plain)->Range(64, 1 << 16);
+
+static void sum_chain_expr(benchmark::State& state) {
+  using bigint_expr::ref;
+  auto c = coefficients(4, state.range(0));
+  big_integer r;
+  for (auto _ : state) {
+    bigint_expr::assign(r, ref(c[0]) + ref(c[1]) - ref(c[2]) + ref(c[3]));
+    benchmark::DoNotOptimize(r);
+  }
+}
+BENCHMARK(sum_chain_expr)->Range(64, 1 << 16);
+
+static void accumulate_small(benchmark::State& state) {
+  auto c = coefficients(1, state.range(0));
+  for (auto _ : state) {
+    big_integer r = c[0];
+    for (int i = 0; i < 1000; ++i) {
+      r += i;
+      r -= 7;
+    }
+    benchmark::DoNotOptimize(r);
+  }
+}
+BENCHMARK(accumulate_small)->Range(64, 1 << 16);
+
+static void accumulate_mixed_sign(benchmark::State& state) {
+  auto c = coefficients(64, state.range(0));
+  for (size_t i = 0; i < c.size(); i += 2) {
+    c[i] = -c[i];
+  }
+  for (auto _ : state) {
+    big_integer r;
+    for (int k = 0; k < 16; ++k) {
+      for (auto const& ci : c) {
+        r += ci;
+      }
+    }
+    benchmark::DoNotOptimize(r);
+  }
+}
+BENCHMARK(accumulate_mixed_sign)->Range(64, 1 << 16);
+
+static void hash_limbs(benchmark::State& state) {
+  auto c = coefficients(1, state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    big_integer key = c[0];
+    key += 0;
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(std::hash<big_integer>()(key));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * 2 / 5);
+}
+BENCHMARK(hash_limbs)->Range(64, 1 << 20);
+
+static void hash_map_lookup(benchmark::State& state) {
+  auto keys = coefficients(64, state.range(0));
+  std::unordered_map<big_integer, size_t> map;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    map[keys[i]] = i;
+  }
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(map.find(keys[i++ % keys.size()]));
+  }
+}
+BENCHMARK(hash_map_lookup)->Range(64, 1 << 16);
+
+static void radix_to_string(benchmark::State& state) {
+  auto c = coefficients(1, state.range(0));
+  int base = static_cast<int>(state.range(1));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(to_string(c[0], base));
+  }
+}
+BENCHMARK(radix_to_string)
+    ->ArgsProduct({benchmark::CreateRange(64, 1 << 17, 8), {10, 16, 7}});
+
+static void radix_from_string(benchmark::State& state) {
+  auto c = coefficients(1, state.range(0));
+  int base = static_cast<int>(state.range(1));
+  std::string str = to_string(c[0], base);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(from_string(str, base));
+  }
+}
+BENCHMARK(radix_from_string)
+    ->ArgsProduct({benchmark::CreateRange(64, 1 << 17, 8), {10, 16, 7}});
+
+static void stream_input(benchmark::State& state) {
+  auto c = coefficients(1, state.range(0));
+  std::string str = to_string(c[0]);
+  for (auto _ : state) {
+    std::istringstream in(str);
+    big_integer a;
+    in >> a;
+    benchmark::DoNotOptimize(a);
+  }
+}
+BENCHMARK(stream_input)->Range(64, 1 << 17);
+
+namespace {
+big_integer random_limbs(size_t limbs, bool negative) {
+  std::mt19937 rng(limbs * 7 + negative);
+  std::string str(limbs * 8, '0');
+  for (char& c : str) {
+    c = "0123456789abcdef"[rng() % 16];
+  }
+  str[0] = '1';
+  big_integer res = from_string(str, 16);
+  return negative ? -res : res;
+}
+
+void report(benchmark::State& state, size_t allocs) {
+  state.counters["per_limb"] = benchmark::Counter(
+      static_cast<double>(state.range(0)),
+      benchmark::Counter::kIsIterationInvariantRate |
+          benchmark::Counter::kInvert);
+  state.counters["allocs"] = benchmark::Counter(
+      static_cast<double>(allocs), benchmark::Counter::kAvgIterations);
+}
+
+template <typename Op>
+void binary_op(benchmark::State& state, Op op) {
+  big_integer a = random_limbs(state.range(0), state.range(2) & 1);
+  big_integer b = random_limbs(state.range(1), state.range(2) & 2);
+  size_t before = allocations.load();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(op(a, b));
+  }
+  report(state, allocations.load() - before);
+}
+
+template <typename Op>
+void unary_op(benchmark::State& state, Op op) {
+  big_integer a = random_limbs(state.range(0), state.range(2) & 1);
+  size_t before = allocations.load();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(op(a));
+  }
+  report(state, allocations.load() - before);
+}
+
+// same-size, signed and mixed-size operand pairs
+void sizes(benchmark::internal::Benchmark* b, int64_t max_limbs) {
+  for (int64_t n = 1; n <= max_limbs; n *= 8) {
+    b->Args({n, n, 0});
+    b->Args({n, n, 3});
+    b->Args({n, std::max<int64_t>(1, n / 8), 0});
+    b->Args({n, std::max<int64_t>(1, n / 8), 1});
+  }
+}
+
+void linear_sizes(benchmark::internal::Benchmark* b) {
+  sizes(b, 1 << 20);
+}
+
+void quadratic_sizes(benchmark::internal::Benchmark* b) {
+  sizes(b, 1 << 14);
+}
+
+void quadratic_unary_sizes(benchmark::internal::Benchmark* b) {
+  for (int64_t n = 1; n <= (1 << 14); n *= 8) {
+    b->Args({n, 0, 0});
+    b->Args({n, 0, 1});
+  }
+}
+
+void linear_unary_sizes(benchmark::internal::Benchmark* b) {
+  for (int64_t n = 1; n <= (1 << 20); n *= 8) {
+    b->Args({n, 0, 0});
+    b->Args({n, 0, 1});
+  }
+}
+} // namespace
+
+BENCHMARK_CAPTURE(binary_op, add, [](auto const& a, auto const& b) {
+  return a + b;
+})->Apply(linear_sizes);
+BENCHMARK_CAPTURE(binary_op, sub, [](auto const& a, auto const& b) {
+  return a - b;
+})->Apply(linear_sizes);
+BENCHMARK_CAPTURE(binary_op, mul, [](auto const& a, auto const& b) {
+  return a * b;
+})->Apply(quadratic_sizes);
+BENCHMARK_CAPTURE(binary_op, div, [](auto const& a, auto const& b) {
+  return a / b;
+})->Apply(quadratic_sizes);
+BENCHMARK_CAPTURE(binary_op, mod, [](auto const& a, auto const& b) {
+  return a % b;
+})->Apply(quadratic_sizes);
+BENCHMARK_CAPTURE(binary_op, and, [](auto const& a, auto const& b) {
+  return a & b;
+})->Apply(linear_sizes);
+BENCHMARK_CAPTURE(binary_op, xor, [](auto const& a, auto const& b) {
+  return a ^ b;
+})->Apply(linear_sizes);
+BENCHMARK_CAPTURE(binary_op, less, [](auto const& a, auto const& b) {
+  return a < b;
+})->Apply(linear_sizes);
+BENCHMARK_CAPTURE(binary_op, equal, [](auto const& a, auto const& b) {
+  return a == b;
+})->Apply(linear_sizes);
+
+BENCHMARK_CAPTURE(unary_op, negate, [](auto const& a) {
+  return -a;
+})->Apply(linear_unary_sizes);
+BENCHMARK_CAPTURE(unary_op, shl, [](auto const& a) {
+  return a << 77;
+})->Apply(linear_unary_sizes);
+BENCHMARK_CAPTURE(unary_op, shr, [](auto const& a) {
+  return a >> 77;
+})->Apply(linear_unary_sizes);
+BENCHMARK_CAPTURE(unary_op, div_small, [](auto const& a) {
+  return a / 1000000007;
+})->Apply(linear_unary_sizes);
+BENCHMARK_CAPTURE(unary_op, to_string_hex, [](auto const& a) {
+  return to_string(a, 16);
+})->Apply(linear_unary_sizes);
+BENCHMARK_CAPTURE(unary_op, to_string, [](auto const& a) {
+  return to_string(a);
+})->Apply(quadratic_unary_sizes);
+
+static void string_ctor(benchmark::State& state) {
+  std::string str = to_string(random_limbs(state.range(0), state.range(2)));
+  size_t before = allocations.load();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(big_integer(str));
+  }
+  report(state, allocations.load() - before);
+}
+BENCHMARK(string_ctor)->Apply(quadratic_unary_sizes);
+
+namespace {
+// atan(1 / x) = sum (-1)^k / ((2k + 1) x^(2k + 1))
+big_float arctan_inverse(uint32_t x, size_t precision) {
+  big_float power = big_float(1, 0, precision) / big_float(x);
+  big_float x2(x * x);
+  big_float sum = power;
+  for (uint32_t k = 1;; ++k) {
+    power /= x2;
+    if (power.exponent() + static_cast<int64_t>(power.precision()) <
+        -static_cast<int64_t>(precision)) {
+      return sum;
+    }
+    big_float term = power / big_float(2 * k + 1);
+    if (k % 2 == 0) {
+      sum += term;
+    } else {
+      sum -= term;
+    }
+  }
+}
+} // namespace
+
+// Machin's formula pi = 16 atan(1/5) - 4 atan(1/239)
+static void pi_digits(benchmark::State& state) {
+  size_t digits = state.range(0);
+  size_t precision = digits * 10 / 3 + 32;
+  std::string pi;
+  for (auto _ : state) {
+    big_float res = big_float(16) * arctan_inverse(5, precision) -
+                    big_float(4) * arctan_inverse(239, precision);
+    pi = to_string(res, digits);
+  }
+  if (pi.compare(0, 12, "3.1415926535") != 0) {
+    state.SkipWithError("wrong digits of pi");
+  }
+  state.counters["digits"] = static_cast<double>(digits);
+}
+BENCHMARK(pi_digits)->RangeMultiplier(10)->Range(100, 10000)
+    ->Unit(benchmark::kMillisecond);
+
+// 4096 products of operands from 1 to range(0) limbs, so that the cost per
+// element varies widely; the output columns are reused between iterations
+namespace {
+void columns(size_t limbs, std::vector<big_integer>& a,
+             std::vector<big_integer>& b) {
+  std::mt19937 rng(static_cast<unsigned>(limbs));
+  for (size_t i = 0; i < 4096; ++i) {
+    a.push_back(random_limbs(1 + rng() % limbs, rng() % 2));
+    b.push_back(random_limbs(1 + rng() % limbs, rng() % 2));
+  }
+}
+} // namespace
+
+static void columns_loop(benchmark::State& state) {
+  std::vector<big_integer> a, b;
+  columns(state.range(0), a, b);
+  std::vector<big_integer> out(a.size());
+  size_t before = allocations.load();
+  for (auto _ : state) {
+    for (size_t i = 0; i < a.size(); ++i) {
+      out[i] = a[i] * b[i];
+    }
+  }
+  report(state, allocations.load() - before);
+}
+BENCHMARK(columns_loop)->Range(4, 256)->Unit(benchmark::kMillisecond);
+
+static void columns_batch(benchmark::State& state) {
+  std::vector<big_integer> a, b;
+  columns(state.range(0), a, b);
+  std::vector<big_integer> out;
+  size_t before = allocations.load();
+  for (auto _ : state) {
+    batch_mul(out, a, b);
+  }
+  report(state, allocations.load() - before);
+}
+BENCHMARK(columns_batch)->Range(4, 256)->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
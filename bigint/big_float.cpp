@@ -0,0 +1,318 @@
+#include "big_float.h"
+#include <algorithm>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+int sign(big_integer const& a) {
+  return (a.is_negative() ? -1 : (a.is_zero() ? 0 : 1));
+}
+
+big_integer shl(big_integer a, int64_t bits) {
+  return a <<= static_cast<int>(bits);
+}
+
+big_integer shr(big_integer a, int64_t bits) {
+  return a >>= static_cast<int>(bits);
+}
+
+big_integer power(big_integer base, size_t exp) {
+  big_integer res = 1;
+  while (exp != 0) {
+    if (exp & 1) {
+      res *= base;
+    }
+    exp >>= 1;
+    if (exp != 0) {
+      base *= base;
+    }
+  }
+  return res;
+}
+} // namespace
+
+big_float::big_float(int a) : mantissa_(a) {
+  round();
+}
+
+big_float::big_float(big_integer mantissa, int64_t exponent, size_t precision)
+    : mantissa_(std::move(mantissa)), exponent_(exponent),
+      precision_(precision) {
+  if (precision_ == 0) {
+    throw std::invalid_argument("Zero precision");
+  }
+  round();
+}
+
+// Rounds to precision_ bits, to nearest with ties to even. Operations that
+// cannot be computed exactly produce at least precision_ + 2 bits and a
+// nonzero lowest bit for a nonzero remainder, which rounds the same way as
+// the exact result.
+void big_float::round() {
+  if (mantissa_.is_zero()) {
+    exponent_ = 0;
+    return;
+  }
+  size_t length = mantissa_.bit_length();
+  if (length <= precision_) {
+    return;
+  }
+  bool negative = mantissa_.is_negative();
+  big_integer m = abs(std::move(mantissa_));
+  int64_t shift = length - precision_;
+  big_integer q = shr(m, shift);
+  big_integer low = m - shl(q, shift);
+  big_integer half = shl(1, shift - 1);
+  if (low > half || (low == half && !(q & 1).is_zero())) {
+    ++q;
+    if (q.bit_length() > precision_) {
+      q >>= 1;
+      ++shift;
+    }
+  }
+  mantissa_ = (negative ? -q : q);
+  exponent_ += shift;
+}
+
+int64_t big_float::top() const {
+  return exponent_ + static_cast<int64_t>(mantissa_.bit_length());
+}
+
+void big_float::add(big_float const& rhs, bool subtract) {
+  precision_ = std::max(precision_, rhs.precision_);
+  big_integer rm = (subtract ? -rhs.mantissa_ : rhs.mantissa_);
+  if (rm.is_zero()) {
+    round();
+    return;
+  }
+  if (mantissa_.is_zero()) {
+    mantissa_ = std::move(rm);
+    exponent_ = rhs.exponent_;
+    round();
+    return;
+  }
+  bool rhs_larger = (rhs.top() > top());
+  big_integer const& big_m = (rhs_larger ? rm : mantissa_);
+  big_integer const& small_m = (rhs_larger ? mantissa_ : rm);
+  int64_t big_e = (rhs_larger ? rhs.exponent_ : exponent_);
+  int64_t small_top = (rhs_larger ? top() : rhs.top());
+  // with at least precision + 3 bits in the larger operand, anything below
+  // its last bit only decides the direction of rounding
+  int64_t k = std::max<int64_t>(
+      0, static_cast<int64_t>(precision_ + 3 - big_m.bit_length()));
+  if (small_top <= big_e - k) {
+    big_integer m = shl(big_m, k + 1);
+    if (small_m.is_negative()) {
+      --m;
+    } else {
+      ++m;
+    }
+    mantissa_ = std::move(m);
+    exponent_ = big_e - k - 1;
+  } else {
+    int64_t e = std::min(exponent_, rhs.exponent_);
+    mantissa_ = shl(std::move(mantissa_), exponent_ - e);
+    mantissa_ += shl(std::move(rm), rhs.exponent_ - e);
+    exponent_ = e;
+  }
+  round();
+}
+
+big_float& big_float::operator+=(big_float const& rhs) {
+  add(rhs, false);
+  return *this;
+}
+
+big_float& big_float::operator-=(big_float const& rhs) {
+  add(rhs, true);
+  return *this;
+}
+
+big_float& big_float::operator*=(big_float const& rhs) {
+  mantissa_ *= rhs.mantissa_;
+  exponent_ += rhs.exponent_;
+  precision_ = std::max(precision_, rhs.precision_);
+  round();
+  return *this;
+}
+
+big_float& big_float::operator/=(big_float const& rhs) {
+  if (rhs.mantissa_.is_zero()) {
+    throw std::invalid_argument("Division by zero");
+  }
+  precision_ = std::max(precision_, rhs.precision_);
+  if (mantissa_.is_zero()) {
+    return *this;
+  }
+  bool negative = mantissa_.is_negative() != rhs.mantissa_.is_negative();
+  big_integer a = abs(std::move(mantissa_));
+  big_integer b = abs(rhs.mantissa_);
+  // the quotient gets at least precision + 2 bits
+  int64_t s = std::max<int64_t>(
+      0, static_cast<int64_t>(precision_ + 2 + b.bit_length()) -
+             static_cast<int64_t>(a.bit_length()));
+  a <<= static_cast<int>(s);
+  big_integer q = a / b;
+  bool inexact = (q * b != a);
+  q <<= 1;
+  if (inexact) {
+    ++q;
+  }
+  mantissa_ = (negative ? -q : q);
+  exponent_ = exponent_ - rhs.exponent_ - s - 1;
+  round();
+  return *this;
+}
+
+big_float big_float::operator+() const {
+  return *this;
+}
+
+big_float big_float::operator-() const {
+  big_float res = *this;
+  res.mantissa_ = -res.mantissa_;
+  return res;
+}
+
+int big_float::compare(big_float const& a, big_float const& b) {
+  int sa = sign(a.mantissa_);
+  int sb = sign(b.mantissa_);
+  if (sa != sb || sa == 0) {
+    return (sa < sb ? -1 : (sa > sb ? 1 : 0));
+  }
+  int64_t ta = a.top();
+  int64_t tb = b.top();
+  if (ta != tb) {
+    return (ta < tb ? -sa : sa);
+  }
+  int64_t e = std::min(a.exponent_, b.exponent_);
+  big_integer x = shl(a.mantissa_, a.exponent_ - e);
+  big_integer y = shl(b.mantissa_, b.exponent_ - e);
+  return (x < y ? -1 : (x == y ? 0 : 1));
+}
+
+bool operator==(big_float const& a, big_float const& b) {
+  return big_float::compare(a, b) == 0;
+}
+
+bool operator!=(big_float const& a, big_float const& b) {
+  return big_float::compare(a, b) != 0;
+}
+
+bool operator<(big_float const& a, big_float const& b) {
+  return big_float::compare(a, b) < 0;
+}
+
+bool operator>(big_float const& a, big_float const& b) {
+  return big_float::compare(a, b) > 0;
+}
+
+bool operator<=(big_float const& a, big_float const& b) {
+  return big_float::compare(a, b) <= 0;
+}
+
+bool operator>=(big_float const& a, big_float const& b) {
+  return big_float::compare(a, b) >= 0;
+}
+
+big_float operator+(big_float a, big_float const& b) {
+  return a += b;
+}
+
+big_float operator-(big_float a, big_float const& b) {
+  return a -= b;
+}
+
+big_float operator*(big_float a, big_float const& b) {
+  return a *= b;
+}
+
+big_float operator/(big_float a, big_float const& b) {
+  return a /= b;
+}
+
+big_float sqrt(big_float const& a) {
+  if (a.mantissa_.is_negative()) {
+    throw std::invalid_argument("Square root of a negative number");
+  }
+  big_float res = a;
+  if (a.mantissa_.is_zero()) {
+    return res;
+  }
+  // the root gets at least precision + 2 bits
+  int64_t s = std::max<int64_t>(
+      0, static_cast<int64_t>(2 * (a.precision_ + 2)) -
+             static_cast<int64_t>(a.mantissa_.bit_length()));
+  if ((a.exponent_ - s) % 2 != 0) {
+    ++s;
+  }
+  big_integer n = shl(a.mantissa_, s);
+  big_integer r = isqrt(n);
+  bool inexact = (r * r != n);
+  r <<= 1;
+  if (inexact) {
+    ++r;
+  }
+  res.mantissa_ = std::move(r);
+  res.exponent_ = (a.exponent_ - s) / 2 - 1;
+  res.round();
+  return res;
+}
+
+big_integer const& big_float::mantissa() const {
+  return mantissa_;
+}
+
+int64_t big_float::exponent() const {
+  return exponent_;
+}
+
+size_t big_float::precision() const {
+  return precision_;
+}
+
+void big_float::set_precision(size_t precision) {
+  if (precision == 0) {
+    throw std::invalid_argument("Zero precision");
+  }
+  precision_ = precision;
+  round();
+}
+
+bool big_float::is_zero() const {
+  return mantissa_.is_zero();
+}
+
+std::string to_string(big_float const& a, size_t digits) {
+  big_integer x = abs(a.mantissa_) * power(10, digits);
+  if (a.exponent_ >= 0) {
+    x = shl(std::move(x), a.exponent_);
+  } else {
+    x += shl(1, -a.exponent_ - 1);
+    x = shr(std::move(x), -a.exponent_);
+  }
+  std::string str = to_string(x);
+  if (str.size() <= digits) {
+    str.insert(0, digits + 1 - str.size(), '0');
+  }
+  if (digits != 0) {
+    str.insert(str.size() - digits, 1, '.');
+  }
+  if (a.mantissa_.is_negative() && !x.is_zero()) {
+    str.insert(0, 1, '-');
+  }
+  return str;
+}
+
+std::string to_string(big_float const& a) {
+  // log10(2) ~ 0.30103
+  size_t bits = (a.exponent() < 0
+                     ? std::min<uint64_t>(-a.exponent(), a.precision())
+                     : 0);
+  return to_string(a, bits * 30103 / 100000);
+}
+
+std::ostream& operator<<(std::ostream& s, big_float const& a) {
+  return s << to_string(a);
+}
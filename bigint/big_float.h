@@ -0,0 +1,70 @@
+#pragma once
+
+#include "big_integer.h"
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+// Binary floating point number mantissa * 2^exponent with a mantissa of at
+// most precision() bits. Every operation is computed exactly and rounded
+// once to nearest, ties to even, so results are correctly rounded. The
+// result of a binary operation has the larger of the operand precisions.
+struct big_float {
+  static constexpr size_t DEFAULT_PRECISION = 64;
+
+  big_float() = default;
+  big_float(int a);
+  big_float(big_integer mantissa, int64_t exponent = 0,
+            size_t precision = DEFAULT_PRECISION);
+
+  big_float& operator+=(big_float const& rhs);
+  big_float& operator-=(big_float const& rhs);
+  big_float& operator*=(big_float const& rhs);
+  big_float& operator/=(big_float const& rhs);
+
+  big_float operator+() const;
+  big_float operator-() const;
+
+  friend bool operator==(big_float const& a, big_float const& b);
+  friend bool operator!=(big_float const& a, big_float const& b);
+  friend bool operator<(big_float const& a, big_float const& b);
+  friend bool operator>(big_float const& a, big_float const& b);
+  friend bool operator<=(big_float const& a, big_float const& b);
+  friend bool operator>=(big_float const& a, big_float const& b);
+
+  friend big_float sqrt(big_float const& a);
+  friend std::string to_string(big_float const& a, size_t digits);
+
+  big_integer const& mantissa() const;
+  int64_t exponent() const;
+  size_t precision() const;
+  // rounds to the new precision
+  void set_precision(size_t precision);
+  bool is_zero() const;
+
+private:
+  big_integer mantissa_;
+  int64_t exponent_ = 0;
+  size_t precision_ = DEFAULT_PRECISION;
+
+  void round();
+  void add(big_float const& rhs, bool subtract);
+  // exponent of the bit just above the most significant one
+  int64_t top() const;
+  // sign of a - b
+  static int compare(big_float const& a, big_float const& b);
+};
+
+big_float operator+(big_float a, big_float const& b);
+big_float operator-(big_float a, big_float const& b);
+big_float operator*(big_float a, big_float const& b);
+big_float operator/(big_float a, big_float const& b);
+
+big_float sqrt(big_float const& a);
+// fixed point decimal with the given number of digits after the point,
+// rounded to nearest
+std::string to_string(big_float const& a, size_t digits);
+// as many fractional digits as the precision gives
+std::string to_string(big_float const& a);
+std::ostream& operator<<(std::ostream& s, big_float const& a);
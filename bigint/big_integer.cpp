@@ -1,12 +1,40 @@
 #include "big_integer.h"
+#include "big_integer_constexpr.h"
+#include "big_integer_ntt.h"
 #include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cerrno>
 #include <cstddef>
+#include <ios>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <unistd.h>
 
-const big_integer ONE = 1;
+// wyhash constants
+constexpr uint64_t HASH_SECRET[4] = {
+    0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull,
+    0x589965cc75374cc3ull};
 constexpr uint64_t BASE = (1ull << 32);
-constexpr size_t MOD_D = 9;
-constexpr uint32_t MOD = 1000000000;
+// numbers of at most this many limbs are converted digit by digit,
+// larger ones are split in halves by powers of the base
+constexpr size_t RADIX_THRESHOLD = 256;
+constexpr char DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+// 10^(9*2^k), the powers used by decimal conversion, computed at compile time
+constexpr size_t DECIMAL_POWERS = 9;
+constexpr auto DECIMAL_POWER_TABLE = [] {
+  std::array<fixed_integer<decimal_limbs(9 << (DECIMAL_POWERS - 1))>,
+             DECIMAL_POWERS>
+      res;
+  res[0] = 1000000000;
+  for (size_t k = 1; k < DECIMAL_POWERS; ++k) {
+    res[k] = res[k - 1] * res[k - 1];
+  }
+  return res;
+}();
 
 void big_integer::int_constructor(uint64_t a) {
   do {
@@ -40,34 +68,11 @@ big_integer::big_integer(unsigned long long a) : sign_(false) {
   int_constructor(static_cast<uint64_t>(a));
 }
 
-big_integer::big_integer(std::string const& str) : big_integer() {
-  if (str.empty() || str == "-") {
-    throw std::invalid_argument("Find empty string");
-  }
-  for (size_t i = ((str[0] == '-') ? 1 : 0); i < str.size(); ++i) {
-    uint32_t temp = 0;
-    uint32_t mul = 1;
-    size_t start_ind = std::min(i + MOD_D, str.size()) - 1;
-    for (size_t j = start_ind; ; --j) {
-      if (str[j] < '0' || str[j] > '9') {
-        throw std::invalid_argument(std::string("Expected digit, find: ") + str[j]);
-      }
-      temp += (str[j] - '0') * mul;
-      mul *= 10;
-      if (j == i) {
-        break;
-      }
-    }
-    i = start_ind;
-    this->mul_small(mul);
-    this->add_small(temp);
-  }
-  if (str[0] == '-' && !is_zero()) {
-    negate();
-  }
-}
+big_integer::big_integer(std::string const& str)
+    : big_integer(from_string(str, 10)) {}
 
 big_integer& big_integer::negate() {
+  reset_hash();
   sign_ = !sign_;
   for (size_t i = 0; i < data_.size(); ++i) {
     data_[i] = ~data_[i];
@@ -78,6 +83,7 @@ big_integer& big_integer::negate() {
 }
 
 big_integer& big_integer::add_small(uint32_t rhs) {
+  reset_hash();
   uint64_t temp = rhs;
   for (size_t i = 0; i < data_.size() && temp > 0; ++i) {
     temp += data_[i];
@@ -85,12 +91,19 @@ big_integer& big_integer::add_small(uint32_t rhs) {
     temp >>= 32;
   }
   if (temp > 0) {
-    data_.push_back(temp);
+    // a carry out of a negative number consumes its sign extension
+    if (sign_) {
+      temp += UINT32_MAX;
+      sign_ = false;
+    }
+    data_.push_back(temp % BASE);
   }
+  shrink_to_fit();
   return *this;
 }
 
 big_integer& big_integer::mul_small(uint32_t rhs) {
+  reset_hash();
   uint32_t carry = 0;
   for (size_t i = 0; i < data_.size(); ++i) {
     uint64_t temp = data_[i];
@@ -105,6 +118,7 @@ big_integer& big_integer::mul_small(uint32_t rhs) {
 }
 
 uint32_t big_integer::div_small(uint32_t rhs) {
+  reset_hash();
   if (data_.empty()) {
     return 0;
   }
@@ -123,29 +137,170 @@ uint32_t big_integer::div_small(uint32_t rhs) {
   return carry;
 }
 
-big_integer& big_integer::operator+=(big_integer const& rhs) {
-  size_t m = std::max(data_.size(), rhs.data_.size()) + 1;
-  expand(m);
-  uint64_t carry = 0u;
-  for (size_t i = 0; i < m; ++i) {
-    carry += get_digit(i);
-    carry += rhs.get_digit(i);
-    data_[i] = carry % BASE;
+big_integer& big_integer::add(big_integer const& rhs, bool subtract) {
+  return add(rhs.sign_, rhs.data_.data(), rhs.data_.size(), subtract);
+}
+
+// rhs may point into data_, it is only read before data_ grows past its
+// current size
+big_integer& big_integer::add(bool rhs_sign, uint32_t const* rhs,
+                              size_t rhs_size, bool subtract) {
+  reset_hash();
+  // a - b is computed as a + ~b + 1
+  uint32_t mask = (subtract ? UINT32_MAX : 0u);
+  uint32_t ext = (sign_ ? UINT32_MAX : 0u);
+  uint32_t rhs_ext = (rhs_sign ? UINT32_MAX : 0u) ^ mask;
+  size_t n = std::max(data_.size(), rhs_size);
+  expand(n);
+  uint64_t carry = (subtract ? 1u : 0u);
+  for (size_t i = 0; i < rhs_size; ++i) {
+    carry += data_[i];
+    carry += rhs[i] ^ mask;
+    data_[i] = static_cast<uint32_t>(carry);
     carry >>= 32;
   }
-  sign_ = (data_.back() >> 31);
+  // past the end of rhs the limbs only change while the carry propagates
+  for (size_t i = rhs_size; i < n && (carry != 0) != (rhs_ext != 0); ++i) {
+    carry += data_[i];
+    carry += rhs_ext;
+    data_[i] = static_cast<uint32_t>(carry);
+    carry >>= 32;
+  }
+  auto top = static_cast<uint32_t>(carry + ext + rhs_ext);
+  sign_ = (top >> 31);
+  if (top != (sign_ ? UINT32_MAX : 0u)) {
+    data_.push_back(top);
+  }
   shrink_to_fit();
   return *this;
 }
 
+big_integer& big_integer::operator+=(big_integer const& rhs) {
+  BIGINT_RECORD(add, std::max(data_.size(), rhs.data_.size()));
+  return add(rhs, false);
+}
+
 big_integer& big_integer::operator-=(big_integer const& rhs) {
-  size_t m = std::max(data_.size(), rhs.data_.size()) + 1;
-  expand(m);
-  int64_t carry = 0u;
+  BIGINT_RECORD(sub, std::max(data_.size(), rhs.data_.size()));
+  return add(rhs, true);
+}
+
+big_integer& big_integer::add_native(native const& rhs, bool subtract) {
+  if (subtract) {
+    BIGINT_RECORD(sub, data_.size());
+  } else {
+    BIGINT_RECORD(add, data_.size());
+  }
+  return add(rhs.sign, rhs.data, rhs.size, subtract);
+}
+
+big_integer& big_integer::mul_native(native const& rhs) {
+  BIGINT_RECORD(mul, data_.size());
+  reset_hash();
+  bool sign = sign_ ^ rhs.sign;
+  if (sign_) {
+    negate();
+  }
+  uint64_t y = rhs.magnitude;
+  if (y <= UINT32_MAX) {
+    mul_small(static_cast<uint32_t>(y));
+  } else {
+    unsigned __int128 carry = 0;
+    for (size_t i = 0; i < data_.size(); ++i) {
+      carry += static_cast<unsigned __int128>(data_[i]) * y;
+      data_[i] = static_cast<uint32_t>(carry);
+      carry >>= 32;
+    }
+    for (; carry != 0; carry >>= 32) {
+      data_.push_back(static_cast<uint32_t>(carry));
+    }
+  }
+  shrink_to_fit();
+  if (sign && !is_zero()) {
+    negate();
+  }
+  return *this;
+}
+
+big_integer& big_integer::div_native(native const& rhs, bool div) {
+  if (div) {
+    BIGINT_RECORD(div, data_.size());
+  } else {
+    BIGINT_RECORD(mod, data_.size());
+  }
+  uint64_t d = rhs.magnitude;
+  if (d == 0) {
+    throw std::invalid_argument("Division by zero");
+  }
+  reset_hash();
+  bool negative = sign_;
+  if (negative) {
+    negate();
+  }
+  uint64_t rem;
+  if (d <= UINT32_MAX) {
+    rem = div_small(static_cast<uint32_t>(d));
+  } else {
+    unsigned __int128 r = 0;
+    for (size_t i = data_.size(); i-- > 0;) {
+      r = (r << 32) | data_[i];
+      data_[i] = static_cast<uint32_t>(r / d);
+      r %= d;
+    }
+    rem = static_cast<uint64_t>(r);
+    shrink_to_fit();
+  }
+  if (div) {
+    if ((negative != rhs.sign) && !is_zero()) {
+      negate();
+    }
+  } else {
+    // the remainder takes the sign of the dividend
+    data_.clear();
+    int_constructor(rem);
+    if (negative && rem != 0) {
+      negate();
+    }
+  }
+  return *this;
+}
+
+int big_integer::compare_native(native const& rhs) const {
+  BIGINT_RECORD(compare, data_.size());
+  if (sign_ != rhs.sign) {
+    return (sign_ ? -1 : 1);
+  }
+  if (data_.size() != rhs.size) {
+    return ((data_.size() < rhs.size) != sign_ ? -1 : 1);
+  }
+  for (size_t i = data_.size(); i-- > 0;) {
+    if (data_[i] != rhs.data[i]) {
+      return (data_[i] < rhs.data[i] ? -1 : 1);
+    }
+  }
+  return 0;
+}
+
+big_integer& big_integer::assign_sum(big_integer const* const* terms,
+                                     bool const* negative, size_t count) {
+  reset_hash();
+  size_t m = 0;
+  for (size_t t = 0; t < count; ++t) {
+    m = std::max(m, terms[t]->data_.size());
+  }
+  ++m;
+  // a term aliasing *this reads its sign extension from the new limbs
+  data_.resize(m, sign_ ? UINT32_MAX : 0u);
+  // limb i of every term is read before limb i is written, so the terms may
+  // alias *this without a copy
+  int64_t carry = 0;
   for (size_t i = 0; i < m; ++i) {
-    carry += get_digit(i);
-    carry -= rhs.get_digit(i);
-    data_[i] = (carry + BASE) % BASE;
+    for (size_t t = 0; t < count; ++t) {
+      storage const& d = terms[t]->data_;
+      int64_t limb = (i < d.size() ? d[i] : (terms[t]->sign_ ? UINT32_MAX : 0));
+      carry += (negative[t] ? -limb : limb);
+    }
+    data_[i] = static_cast<uint32_t>(carry);
     carry >>= 32;
   }
   sign_ = (data_.back() >> 31);
@@ -154,31 +309,57 @@ big_integer& big_integer::operator-=(big_integer const& rhs) {
 }
 
 big_integer& big_integer::operator*=(big_integer const& rhs) {
-  big_integer res;
+  BIGINT_RECORD(mul, std::max(data_.size(), rhs.data_.size()));
+  BIGINT_TIME(multiply);
+  reset_hash();
   bool sign = sign_ ^ rhs.sign_;
+  big_integer b;
+  big_integer const* abs_rhs = &rhs;
+  if (rhs.sign_ || &rhs == this) {
+    b = rhs;
+    if (b.sign_) {
+      b.negate();
+    }
+    abs_rhs = &b;
+  }
   if (sign_) {
     negate();
   }
-  res.expand(data_.size() + rhs.data_.size());
-  for (size_t i = 0; i < data_.size(); ++i) {
-    uint32_t carry = 0;
-    for (size_t j = 0; (j < rhs.data_.size()) || (carry != 0); ++j) {
-      uint64_t temp = data_[i];
-      temp *= (rhs.sign_ ? ~rhs.get_digit(j) : rhs.get_digit(j));
-      temp += carry;
-      temp += res.get_digit(i + j);
-      res.data_[i + j] = temp;
-      carry = temp >> 32;
+  storage const& y = abs_rhs->data_;
+  size_t n = data_.size();
+  size_t m = y.size();
+  if (std::min(n, m) >= bigint_ntt::THRESHOLD) {
+    // the transform needs a separate output, which replaces the limbs
+    storage res(n + m);
+    // a square passes the same limbs twice, which saves a transform
+    storage const& z = (&rhs == this ? data_ : y);
+    bigint_ntt::multiply(res.data(), data_.data(), n, z.data(), z.size());
+    data_.swap(res);
+  } else {
+    // rows are added from the top: row i reads limb i before clearing it
+    // and only writes limbs from i up, so the product overwrites this
+    // number in place and reuses its capacity
+    data_.resize(n + m, 0);
+    for (size_t i = n; i-- > 0;) {
+      uint64_t x = data_[i];
+      data_[i] = 0;
+      uint64_t carry = 0;
+      for (size_t j = 0; j < m; ++j) {
+        carry += x * y[j] + data_[i + j];
+        data_[i + j] = static_cast<uint32_t>(carry);
+        carry >>= 32;
+      }
+      for (size_t k = i + m; carry != 0; ++k) {
+        carry += data_[k];
+        data_[k] = static_cast<uint32_t>(carry);
+        carry >>= 32;
+      }
     }
   }
-  if (rhs.sign_) {
-    res += *this;
-  }
-  if (sign) {
-    res.negate();
+  shrink_to_fit();
+  if (sign && !is_zero()) {
+    negate();
   }
-  res.shrink_to_fit();
-  std::swap(*this, res);
   return *this;
 }
 
@@ -209,6 +390,7 @@ bool big_integer::smaller(const big_integer& dq, size_t k, size_t m) const {
 }
 
 void big_integer::difference(const big_integer& dq, size_t k, size_t m) {
+  reset_hash();
   uint32_t borrow = 0;
   for (size_t i = 0; i <= m; ++i) {
     uint64_t diff =
@@ -219,6 +401,8 @@ void big_integer::difference(const big_integer& dq, size_t k, size_t m) {
 }
 
 big_integer& big_integer::div_long(const big_integer& rhs, bool div) {
+  BIGINT_TIME(divide);
+  reset_hash();
   bool sign = sign_ ^ rhs.sign_;
   big_integer b = rhs;
   if (b.sign_) {
@@ -235,7 +419,7 @@ big_integer& big_integer::div_long(const big_integer& rhs, bool div) {
     res = *this;
     *this = res.div_small(b.data_[0]);
   } else if (m <= n) {
-    uint32_t f = BASE / (b.data_[m - 1] + 1);
+    uint32_t f = BASE / (static_cast<uint64_t>(b.data_[m - 1]) + 1);
     mul_small(f);
     b.mul_small(f);
     n = data_.size();
@@ -247,7 +431,7 @@ big_integer& big_integer::div_long(const big_integer& rhs, bool div) {
       uint32_t qt = trial(b, k, m);
       dq.data_.assign(b.data_.begin(), b.data_.end());
       dq.mul_small(qt);
-      if (smaller(dq, k, m)) {
+      while (smaller(dq, k, m)) {
         --qt;
         dq -= b;
       }
@@ -258,6 +442,7 @@ big_integer& big_integer::div_long(const big_integer& rhs, bool div) {
       }
     }
     div_small(f);
+    res.shrink_to_fit();
   }
 
   if (div) {
@@ -275,15 +460,19 @@ big_integer& big_integer::div_long(const big_integer& rhs, bool div) {
 }
 
 big_integer& big_integer::operator/=(big_integer const& rhs) {
+  BIGINT_RECORD(div, std::max(data_.size(), rhs.data_.size()));
   return div_long(rhs, true);
 }
 
 big_integer& big_integer::operator%=(big_integer const& rhs) {
+  BIGINT_RECORD(mod, std::max(data_.size(), rhs.data_.size()));
   return div_long(rhs, false);
 }
 
 template <typename F>
 big_integer& big_integer::bitwise(big_integer const& rhs, F func) {
+  BIGINT_RECORD(bitwise, std::max(data_.size(), rhs.data_.size()));
+  reset_hash();
   size_t m = std::max(data_.size(), rhs.data_.size());
   expand(m);
   for (size_t i = 0; i < m; ++i) {
@@ -307,21 +496,36 @@ big_integer& big_integer::operator^=(big_integer const& rhs) {
 }
 
 big_integer& big_integer::operator<<=(int rhs) {
-  *this *= (1u << (rhs % 32));
+  BIGINT_RECORD(shift, data_.size());
+  reset_hash();
+  if (is_zero()) {
+    return *this;
+  }
+  int bits = rhs % 32;
+  if (bits != 0) {
+    data_.push_back(get_digit(data_.size()));
+    for (size_t i = data_.size() - 1; i > 0; --i) {
+      data_[i] = (data_[i] << bits) | (data_[i - 1] >> (32 - bits));
+    }
+    data_[0] <<= bits;
+  }
   data_.insert(data_.begin(), rhs / 32, 0);
+  shrink_to_fit();
   return *this;
 }
 
 big_integer& big_integer::operator>>=(int rhs) {
-  *this /= (1u << (rhs % 32));
-  if (sign_) {
-    --(*this);
-  }
-  size_t m = std::min(data_.size(), static_cast<size_t>(rhs / 32));
-  data_.erase(data_.begin(), data_.begin() + m);
-  if (data_.empty()) {
-    (*this) = big_integer();
+  BIGINT_RECORD(shift, data_.size());
+  reset_hash();
+  size_t words = std::min(data_.size(), static_cast<size_t>(rhs / 32));
+  data_.erase(data_.begin(), data_.begin() + words);
+  int bits = rhs % 32;
+  if (bits != 0) {
+    for (size_t i = 0; i < data_.size(); ++i) {
+      data_[i] = (data_[i] >> bits) | (get_digit(i + 1) << (32 - bits));
+    }
   }
+  shrink_to_fit();
   return *this;
 }
 
@@ -360,8 +564,8 @@ big_integer big_integer::operator++(int) {
 }
 
 big_integer& big_integer::operator--() {
-  *this -= ONE;
-  return *this;
+  // adds -1, which has no limbs
+  return add(true, nullptr, 0, false);
 }
 
 big_integer big_integer::operator--(int) {
@@ -411,6 +615,12 @@ big_integer operator>>(big_integer a, int b) {
 }
 
 bool operator==(big_integer const& a, big_integer const& b) {
+  BIGINT_RECORD(compare, std::max(a.data_.size(), b.data_.size()));
+  size_t ha = a.hash_.value.load(std::memory_order_relaxed);
+  size_t hb = b.hash_.value.load(std::memory_order_relaxed);
+  if (ha != 0 && hb != 0 && ha != hb) {
+    return false;
+  }
   return a.sign_ == b.sign_ && (a.data_ == b.data_);
 }
 
@@ -419,10 +629,12 @@ bool operator!=(big_integer const& a, big_integer const& b) {
 }
 
 bool operator<(big_integer const& a, big_integer const& b) {
+  BIGINT_RECORD(compare, std::max(a.data_.size(), b.data_.size()));
   if (a.sign_ != b.sign_) {
     return a.sign_;
   } else if (a.data_.size() != b.data_.size()) {
-    return a.data_.size() < b.data_.size();
+    // longer negative numbers have more significant non-extension limbs
+    return (a.data_.size() < b.data_.size()) != a.sign_;
   } else {
     return a.smaller(b, 0, a.data_.size());
   }
@@ -440,32 +652,450 @@ bool operator>=(big_integer const& a, big_integer const& b) {
   return !(a < b);
 }
 
-std::string to_string(big_integer const& a) {
-  if (a == 0) {
-    return "0";
+namespace {
+int digit_value(char c) {
+  if ('0' <= c && c <= '9') {
+    return c - '0';
+  } else if ('a' <= c && c <= 'z') {
+    return c - 'a' + 10;
+  } else if ('A' <= c && c <= 'Z') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+void check_base(int base) {
+  if (base < 2 || base > 36) {
+    throw std::invalid_argument("Unsupported base: " + std::to_string(base));
+  }
+}
+
+// log2(base) for power-of-two bases, 0 otherwise
+size_t power_of_two_bits(int base) {
+  size_t bits = 0;
+  while ((1 << bits) < base) {
+    ++bits;
+  }
+  return ((1 << bits) == base ? bits : 0);
+}
+
+// chunk^(2^k) for one base, shared by all conversions. Powers are only
+// appended and never change, so readers need nothing but the published
+// size; the lock is taken only to grow the table.
+struct power_cache {
+  // chunk^(2^48) would not fit in memory
+  static constexpr size_t CAPACITY = 48;
+
+  std::mutex lock;
+  std::atomic<size_t> size {0};
+  std::unique_ptr<big_integer const> powers[CAPACITY];
+};
+
+power_cache& powers_of(uint32_t base) {
+  static power_cache caches[37];
+  return caches[base];
+}
+} // namespace
+
+struct big_integer::radix {
+  explicit radix(uint32_t base)
+      : base(base), chunk_digits(0), chunk(1), cache(powers_of(base)) {
+    while (static_cast<uint64_t>(chunk) * base <= UINT32_MAX) {
+      chunk *= base;
+      ++chunk_digits;
+    }
+  }
+
+  // chunk^(2^k)
+  big_integer const& power(size_t k) {
+    if (k < cache.size.load(std::memory_order_acquire)) {
+      return *cache.powers[k];
+    }
+    std::lock_guard<std::mutex> guard(cache.lock);
+    for (size_t i = cache.size.load(std::memory_order_relaxed); i <= k; ++i) {
+      if (base == 10 && i < DECIMAL_POWERS) {
+        cache.powers[i] = std::make_unique<big_integer const>(
+            DECIMAL_POWER_TABLE[i].to_big_integer());
+      } else if (i == 0) {
+        cache.powers[i] = std::make_unique<big_integer const>(chunk);
+      } else {
+        cache.powers[i] = std::make_unique<big_integer const>(
+            *cache.powers[i - 1] * *cache.powers[i - 1]);
+      }
+      cache.size.store(i + 1, std::memory_order_release);
+    }
+    return *cache.powers[k];
+  }
+
+  uint32_t base;
+  size_t chunk_digits;
+  uint32_t chunk;
+  power_cache& cache;
+};
+
+// Accumulates digits chunk by chunk. Chunks are merged pairwise like a
+// binary counter, so the digit text is never stored and every value is
+// combined with one of equal size.
+struct big_integer::digit_reader {
+  explicit digit_reader(uint32_t base) : r(base) {}
+
+  bool push(char c) {
+    int d = digit_value(c);
+    if (d < 0 || static_cast<uint32_t>(d) >= r.base) {
+      return false;
+    }
+    value = value * r.base + d;
+    if (++digits == r.chunk_digits) {
+      push_block();
+    }
+    empty = false;
+    return true;
   }
 
+  big_integer finish() {
+    big_integer res = value;
+    big_integer scale = 1;
+    for (size_t i = 0; i < digits; ++i) {
+      scale.mul_small(r.base);
+    }
+    for (size_t i = blocks.size(); i-- > 0;) {
+      blocks[i].first *= scale;
+      res += blocks[i].first;
+      if (i > 0) {
+        scale *= r.power(blocks[i].second);
+      }
+    }
+    return res;
+  }
+
+  void push_block() {
+    blocks.emplace_back(value, 0);
+    value = 0;
+    digits = 0;
+    while (blocks.size() >= 2 &&
+           blocks.back().second == blocks[blocks.size() - 2].second) {
+      auto& hi = blocks[blocks.size() - 2];
+      hi.first *= r.power(hi.second);
+      hi.first += blocks.back().first;
+      ++hi.second;
+      blocks.pop_back();
+    }
+  }
+
+  radix r;
+  // value and level, a block of level k holds chunk_digits * 2^k digits
+  std::vector<std::pair<big_integer, size_t>> blocks;
+  uint32_t value = 0;
+  size_t digits = 0;
+  bool empty = true;
+};
+
+big_integer big_integer::parse_radix(std::string_view digits, radix& r) {
+  size_t d = r.chunk_digits;
+  if (digits.size() <= RADIX_THRESHOLD * d) {
+    big_integer res;
+    size_t len = digits.size() % d;
+    len = (len == 0 ? d : len);
+    for (size_t i = 0; i < digits.size(); i += len, len = d) {
+      uint32_t value = 0;
+      uint32_t mul = 1;
+      for (size_t j = i; j < i + len; ++j) {
+        value = value * r.base + digit_value(digits[j]);
+        mul *= r.base;
+      }
+      res.mul_small(mul);
+      res.add_small(value);
+    }
+    return res;
+  }
+  size_t k = 0;
+  while ((d << (k + 1)) < digits.size()) {
+    ++k;
+  }
+  size_t low = d << k;
+  big_integer res = parse_radix(digits.substr(0, digits.size() - low), r);
+  res *= r.power(k);
+  res += parse_radix(digits.substr(digits.size() - low), r);
+  return res;
+}
+
+big_integer big_integer::parse_power_of_two(std::string_view digits,
+                                            size_t bits) {
+  big_integer res;
+  res.data_.reserve(digits.size() * bits / 32 + 1);
+  uint64_t acc = 0;
+  size_t filled = 0;
+  for (size_t i = digits.size(); i-- > 0;) {
+    acc |= static_cast<uint64_t>(digit_value(digits[i])) << filled;
+    filled += bits;
+    if (filled >= 32) {
+      res.data_.push_back(static_cast<uint32_t>(acc));
+      acc >>= 32;
+      filled -= 32;
+    }
+  }
+  if (filled > 0) {
+    res.data_.push_back(static_cast<uint32_t>(acc));
+  }
+  res.shrink_to_fit();
+  return res;
+}
+
+void big_integer::print_radix(std::string& out, size_t width,
+                              radix& r) const {
+  if (data_.size() <= RADIX_THRESHOLD) {
+    big_integer b = *this;
+    std::string digits;
+    while (!b.is_zero()) {
+      uint32_t c = b.div_small(r.chunk);
+      for (size_t j = 0; j < r.chunk_digits; ++j) {
+        digits.push_back(DIGITS[c % r.base]);
+        c /= r.base;
+      }
+    }
+    while (!digits.empty() && digits.back() == '0') {
+      digits.pop_back();
+    }
+    if (digits.size() < width) {
+      digits.append(width - digits.size(), '0');
+    }
+    out.append(digits.rbegin(), digits.rend());
+    return;
+  }
+  size_t k = 0;
+  while (r.power(k).data_.size() * 4 <= data_.size()) {
+    ++k;
+  }
+  big_integer const& p = r.power(k);
+  big_integer q = *this / p;
+  big_integer rem = *this - q * p;
+  size_t low = r.chunk_digits << k;
+  q.print_radix(out, (width > low ? width - low : 0), r);
+  rem.print_radix(out, low, r);
+}
+
+void big_integer::print_power_of_two(std::string& out, size_t bits) const {
+  bool started = false;
+  for (size_t i = (data_.size() * 32 + bits - 1) / bits; i-- > 0;) {
+    size_t pos = i * bits;
+    uint64_t w = get_digit(pos / 32);
+    w |= static_cast<uint64_t>(get_digit(pos / 32 + 1)) << 32;
+    uint32_t digit = (w >> (pos % 32)) & ((1u << bits) - 1);
+    if (digit != 0 || started) {
+      started = true;
+      out.push_back(DIGITS[digit]);
+    }
+  }
+}
+
+big_integer from_string(std::string_view str, int base) {
+  BIGINT_TIME(from_string);
+  check_base(base);
+  bool negative = (!str.empty() && str[0] == '-');
+  std::string_view digits = str.substr(negative ? 1 : 0);
+  if (digits.empty()) {
+    throw std::invalid_argument("Find empty string");
+  }
+  for (char c : digits) {
+    int value = digit_value(c);
+    if (value < 0 || value >= base) {
+      throw std::invalid_argument(std::string("Expected digit, find: ") + c);
+    }
+  }
+  size_t bits = power_of_two_bits(base);
+  big_integer res;
+  if (bits != 0) {
+    res = big_integer::parse_power_of_two(digits, bits);
+  } else {
+    big_integer::radix r(base);
+    res = big_integer::parse_radix(digits, r);
+  }
+  if (negative && !res.is_zero()) {
+    res.negate();
+  }
+  BIGINT_RECORD(from_string, res.data_.size());
+  return res;
+}
+
+big_integer from_limbs(uint32_t const* limbs, size_t size, bool negative) {
+  big_integer res;
+  res.data_.assign(limbs, limbs + size);
+  res.shrink_to_fit();
+  if (negative && !res.is_zero()) {
+    res.negate();
+  }
+  return res;
+}
+
+std::vector<uint32_t> to_limbs(big_integer const& a) {
+  if (a.sign_) {
+    return to_limbs(-a);
+  }
+  return std::vector<uint32_t>(a.data_.begin(), a.data_.end());
+}
+
+std::string to_string(big_integer const& a, int base) {
+  BIGINT_RECORD(to_string, a.data_.size());
+  BIGINT_TIME(to_string);
+  check_base(base);
+  if (a.is_zero()) {
+    return "0";
+  }
   big_integer b = a;
   if (b.sign_) {
     b.negate();
   }
   std::string res;
-  bool fl = false;
-  do {
-    uint32_t d = b.div_small(MOD);
-    fl = (b == 0);
-    for (size_t j = 0; j < MOD_D && (d != 0 || !fl); ++j) {
-      res.push_back(static_cast<char>(d % 10 + '0'));
-      d /= 10;
-    }
-  } while (!fl);
   if (a.sign_) {
     res.push_back('-');
   }
-  std::reverse(res.begin(), res.end());
+  size_t bits = power_of_two_bits(base);
+  if (bits != 0) {
+    b.print_power_of_two(res, bits);
+  } else {
+    big_integer::radix r(base);
+    b.print_radix(res, 0, r);
+  }
+  return res;
+}
+
+std::string to_string(big_integer const& a) {
+  return to_string(a, 10);
+}
+
+std::istream& operator>>(std::istream& s, big_integer& a) {
+  std::istream::sentry sentry(s);
+  if (!sentry) {
+    return s;
+  }
+  int base = 10;
+  if ((s.flags() & std::ios_base::basefield) == std::ios_base::hex) {
+    base = 16;
+  } else if ((s.flags() & std::ios_base::basefield) == std::ios_base::oct) {
+    base = 8;
+  }
+  using traits = std::istream::traits_type;
+  std::streambuf* buf = s.rdbuf();
+  big_integer::digit_reader reader(base);
+  traits::int_type c = buf->sgetc();
+  bool negative = (c == '-');
+  if (c == '-' || c == '+') {
+    c = buf->snextc();
+  }
+  while (!traits::eq_int_type(c, traits::eof()) &&
+         reader.push(traits::to_char_type(c))) {
+    c = buf->snextc();
+  }
+  std::ios_base::iostate state = std::ios_base::goodbit;
+  if (traits::eq_int_type(c, traits::eof())) {
+    state |= std::ios_base::eofbit;
+  }
+  if (reader.empty) {
+    state |= std::ios_base::failbit;
+  } else {
+    a = reader.finish();
+    if (negative && !a.is_zero()) {
+      a.negate();
+    }
+  }
+  s.setstate(state);
+  return s;
+}
+
+big_integer read_big_integer(int fd, int base) {
+  check_base(base);
+  big_integer::digit_reader reader(base);
+  std::vector<char> buf(1 << 16);
+  enum { LEADING, DIGITS, TRAILING } stage = LEADING;
+  bool negative = false;
+  while (true) {
+    ssize_t count = ::read(fd, buf.data(), buf.size());
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count < 0) {
+      throw std::system_error(errno, std::generic_category(),
+                              "read_big_integer");
+    }
+    if (count == 0) {
+      break;
+    }
+    for (ssize_t i = 0; i < count; ++i) {
+      char c = buf[i];
+      bool space = std::isspace(static_cast<unsigned char>(c));
+      if (stage == LEADING) {
+        if (space) {
+          continue;
+        }
+        stage = DIGITS;
+        if (c == '-' || c == '+') {
+          negative = (c == '-');
+          continue;
+        }
+      }
+      if (stage == DIGITS && reader.push(c)) {
+        continue;
+      }
+      if (!space || reader.empty) {
+        throw std::invalid_argument(std::string("Expected digit, find: ") + c);
+      }
+      stage = TRAILING;
+    }
+  }
+  if (reader.empty) {
+    throw std::invalid_argument("Find empty string");
+  }
+  big_integer res = reader.finish();
+  if (negative && !res.is_zero()) {
+    res.negate();
+  }
+  return res;
+}
+
+namespace {
+uint64_t hash_mix(uint64_t a, uint64_t b) {
+  __uint128_t r = static_cast<__uint128_t>(a) * b;
+  return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+}
+
+uint64_t hash_word(uint32_t const* data, size_t i) {
+  return data[i] | (static_cast<uint64_t>(data[i + 1]) << 32);
+}
+} // namespace
+
+size_t big_integer::hash() const {
+  size_t cached = hash_.value.load(std::memory_order_relaxed);
+  if (cached != 0) {
+    return cached;
+  }
+  size_t n = data_.size();
+  uint64_t seed = HASH_SECRET[0] ^ (sign_ ? HASH_SECRET[1] : 0);
+  uint64_t lane = seed;
+  size_t i = 0;
+  // two independent lanes of 128 bits each keep both multipliers busy
+  for (; i + 8 <= n; i += 8) {
+    seed = hash_mix(hash_word(data_.data(), i) ^ HASH_SECRET[1],
+                    hash_word(data_.data(), i + 2) ^ seed);
+    lane = hash_mix(hash_word(data_.data(), i + 4) ^ HASH_SECRET[2],
+                    hash_word(data_.data(), i + 6) ^ lane);
+  }
+  seed = hash_mix(seed ^ HASH_SECRET[2], lane ^ HASH_SECRET[3]);
+  for (; i + 2 <= n; i += 2) {
+    seed = hash_mix(hash_word(data_.data(), i) ^ HASH_SECRET[1],
+                    seed ^ HASH_SECRET[3]);
+  }
+  uint64_t last = (i < n ? data_[i] : 0);
+  uint64_t res =
+      hash_mix(HASH_SECRET[1] ^ n, hash_mix(last ^ HASH_SECRET[1], seed));
+  res = (res == 0 ? 1 : res);
+  hash_.value.store(res, std::memory_order_relaxed);
   return res;
 }
 
+void big_integer::reset_hash() {
+  hash_.value.store(0, std::memory_order_relaxed);
+}
+
 void big_integer::shrink_to_fit() {
   uint32_t temp = (sign_ ? UINT32_MAX : 0u);
   while (!data_.empty() && data_.back() == temp) {
@@ -474,7 +1104,25 @@ void big_integer::shrink_to_fit() {
 }
 
 std::ostream& operator<<(std::ostream& s, big_integer const& a) {
-  return s << to_string(a);
+  std::ios_base::fmtflags flags = s.flags();
+  int base = 10;
+  if ((flags & std::ios_base::basefield) == std::ios_base::hex) {
+    base = 16;
+  } else if ((flags & std::ios_base::basefield) == std::ios_base::oct) {
+    base = 8;
+  }
+  std::string str = to_string(a, base);
+  if ((flags & std::ios_base::uppercase) && base == 16) {
+    std::transform(str.begin(), str.end(), str.begin(),
+                   [](char c) { return std::toupper(c); });
+  }
+  if ((flags & std::ios_base::showbase) && base != 10 && !a.is_zero()) {
+    char const* prefix = (base == 8 ? "0"
+                          : (flags & std::ios_base::uppercase) ? "0X"
+                                                               : "0x");
+    str.insert(a.sign_ ? 1 : 0, prefix);
+  }
+  return s << str;
 }
 
 uint32_t big_integer::get_digit(size_t ind) const {
@@ -482,11 +1130,72 @@ uint32_t big_integer::get_digit(size_t ind) const {
 }
 
 void big_integer::expand(size_t size) {
-  for (size_t i = data_.size(); i < size; ++i) {
-    data_.push_back(sign_ ? UINT32_MAX : 0u);
+  if (data_.size() < size) {
+    data_.resize(size, sign_ ? UINT32_MAX : 0u);
   }
 }
+
+void big_integer::reserve(size_t limbs) {
+  data_.reserve(limbs);
+}
 bool big_integer::is_zero() const {
   return !sign_ && data_.empty();
 }
 
+bool big_integer::is_negative() const {
+  return sign_;
+}
+
+size_t big_integer::bit_length() const {
+  // for negative numbers |x| = ~x + 1
+  uint32_t ext = (sign_ ? UINT32_MAX : 0u);
+  size_t n = data_.size();
+  if (n == 0) {
+    return (sign_ ? 1 : 0);
+  }
+  uint32_t top = data_[n - 1] ^ ext;
+  size_t bits = (n - 1) * 32 + std::bit_width(top);
+  if (sign_ && std::has_single_bit(top + 1ull)) {
+    // + 1 adds a bit only when ~x is all ones
+    bool low_ones = std::all_of(data_.begin(), data_.end() - 1,
+                                [](uint32_t d) { return d == 0; });
+    bits += (low_ones ? 1 : 0);
+  }
+  return bits;
+}
+
+big_integer abs(big_integer a) {
+  if (a.is_negative()) {
+    a.negate();
+  }
+  return a;
+}
+
+big_integer gcd(big_integer a, big_integer b) {
+  a = abs(std::move(a));
+  b = abs(std::move(b));
+  while (!b.is_zero()) {
+    a %= b;
+    std::swap(a, b);
+  }
+  return a;
+}
+
+// Newton's iteration from above
+big_integer isqrt(big_integer const& a) {
+  if (a.is_negative()) {
+    throw std::invalid_argument("Square root of a negative number");
+  }
+  if (a.is_zero()) {
+    return a;
+  }
+  big_integer x = big_integer(1) << static_cast<int>((a.bit_length() + 1) / 2);
+  while (true) {
+    big_integer y = (x + a / x) >> 1;
+    if (y >= x) {
+      return x;
+    }
+    x = std::move(y);
+  }
+}
+
@@ -1,15 +1,35 @@
 #pragma once
 
+#include <atomic>
 #include <climits>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <iosfwd>
+#include <istream>
 #include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <version>
+#include "big_integer_mmap.h"
+#include "big_integer_stats.h"
+#ifdef __cpp_lib_format
+#include <algorithm>
+#include <cctype>
+#include <format>
+#endif
+
+// built-in integers of up to 64 bits, arithmetic and comparisons with them
+// run on the limbs directly instead of through a big_integer temporary
+template <typename T>
+concept native_integer = std::integral<T> && sizeof(T) <= sizeof(uint64_t);
 
 struct big_integer {
   big_integer() = default;
   big_integer(big_integer const& other) = default;
+  big_integer(big_integer&& other) = default;
   big_integer(int a);
   big_integer(unsigned a);
   big_integer(long a);
@@ -20,6 +40,7 @@ struct big_integer {
   ~big_integer() = default;
 
   big_integer& operator=(big_integer const& other) = default;
+  big_integer& operator=(big_integer&& other) = default;
 
   big_integer& operator+=(big_integer const& rhs);
   big_integer& operator-=(big_integer const& rhs);
@@ -27,6 +48,17 @@ struct big_integer {
   big_integer& operator/=(big_integer const& rhs);
   big_integer& operator%=(big_integer const& rhs);
 
+  template <native_integer T>
+  big_integer& operator+=(T rhs);
+  template <native_integer T>
+  big_integer& operator-=(T rhs);
+  template <native_integer T>
+  big_integer& operator*=(T rhs);
+  template <native_integer T>
+  big_integer& operator/=(T rhs);
+  template <native_integer T>
+  big_integer& operator%=(T rhs);
+
   big_integer& operator&=(big_integer const& rhs);
   big_integer& operator|=(big_integer const& rhs);
   big_integer& operator^=(big_integer const& rhs);
@@ -51,20 +83,92 @@ struct big_integer {
   friend bool operator<=(big_integer const& a, big_integer const& b);
   friend bool operator>=(big_integer const& a, big_integer const& b);
 
+  template <native_integer T>
+  friend bool operator==(big_integer const& a, T b);
+  template <native_integer T>
+  friend bool operator<(big_integer const& a, T b);
+  template <native_integer T>
+  friend bool operator>(big_integer const& a, T b);
+
   friend std::string to_string(big_integer const& a);
+  friend std::string to_string(big_integer const& a, int base);
+  friend big_integer from_string(std::string_view str, int base);
+  friend big_integer from_limbs(uint32_t const* limbs, size_t size,
+                                bool negative);
+  friend std::vector<uint32_t> to_limbs(big_integer const& a);
+  friend std::ostream& operator<<(std::ostream& s, big_integer const& a);
+  friend std::istream& operator>>(std::istream& s, big_integer& a);
+  friend big_integer read_big_integer(int fd, int base);
 
   big_integer& add_small(uint32_t rhs);
   big_integer& mul_small(uint32_t rhs);
   big_integer& negate();
   uint32_t div_small(uint32_t rhs);
+  // *this = sum of (negative[i] ? -terms[i] : terms[i]) in a single carry pass,
+  // terms may alias *this
+  big_integer& assign_sum(big_integer const* const* terms, bool const* negative,
+                          size_t count);
   bool is_zero() const;
+  bool is_negative() const;
+  // number of significant bits of the absolute value, 0 for zero
+  size_t bit_length() const;
+  // keeps room for the given number of limbs, it is never released by
+  // arithmetic, so accumulators grow without reallocations
+  void reserve(size_t limbs);
+  // computed on demand and cached until the next modification
+  size_t hash() const;
 
 private:
+#ifdef BIGINT_STATS
+  using storage = std::vector<
+      uint32_t, bigint_stats::detail::counting_allocator<
+                    uint32_t, bigint_mmap::limb_allocator<uint32_t>>>;
+#else
+  using storage = std::vector<uint32_t, bigint_mmap::limb_allocator<uint32_t>>;
+#endif
+
   // - = true, + = false
   bool sign_ {};
-  std::vector<uint32_t> data_;
+  storage data_;
+
+  struct hash_cache {
+    hash_cache() = default;
+    hash_cache(hash_cache const& other)
+        : value(other.value.load(std::memory_order_relaxed)) {}
+    hash_cache& operator=(hash_cache const& other) {
+      value.store(other.value.load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+      return *this;
+    }
+    // the limbs move out with the hash, so the source forgets it
+    hash_cache(hash_cache&& other) noexcept
+        : value(other.value.exchange(0, std::memory_order_relaxed)) {}
+    hash_cache& operator=(hash_cache&& other) noexcept {
+      value.store(other.value.exchange(0, std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+      return *this;
+    }
+    // 0 means not computed yet
+    mutable std::atomic<size_t> value {0};
+  };
+  hash_cache hash_;
 
 private:
+  struct radix;
+  struct digit_reader;
+
+  // a native integer laid out like sign_ and data_
+  struct native {
+    bool sign;
+    size_t size;
+    uint32_t data[2];
+    uint64_t magnitude;
+  };
+
+  template <native_integer T>
+  static native to_native(T a);
+
+  void reset_hash();
   void shrink_to_fit();
   uint32_t trial(const big_integer& d, size_t k, size_t m) const;
   bool smaller(const big_integer& dq, size_t k, size_t m) const;
@@ -75,6 +179,18 @@ private:
   template<typename F>
   big_integer& bitwise(big_integer const& rhs, F func);
   big_integer& div_long(const big_integer& rhs, bool div);
+  big_integer& add(big_integer const& rhs, bool subtract);
+  big_integer& add(bool rhs_sign, uint32_t const* rhs, size_t rhs_size,
+                   bool subtract);
+  big_integer& add_native(native const& rhs, bool subtract);
+  big_integer& mul_native(native const& rhs);
+  big_integer& div_native(native const& rhs, bool div);
+  // sign of *this - rhs
+  int compare_native(native const& rhs) const;
+  static big_integer parse_radix(std::string_view digits, radix& r);
+  static big_integer parse_power_of_two(std::string_view digits, size_t bits);
+  void print_radix(std::string& out, size_t width, radix& r) const;
+  void print_power_of_two(std::string& out, size_t bits) const;
 };
 
 big_integer operator+(big_integer a, big_integer const& b);
@@ -90,6 +206,93 @@ big_integer operator^(big_integer a, big_integer const& b);
 big_integer operator<<(big_integer a, int b);
 big_integer operator>>(big_integer a, int b);
 
+template <native_integer T>
+big_integer::native big_integer::to_native(T a) {
+  native res {};
+  auto bits = static_cast<uint64_t>(a);
+  if constexpr (std::is_signed_v<T>) {
+    res.sign = (a < 0);
+  }
+  res.magnitude = (res.sign ? ~bits + 1 : bits);
+  res.data[0] = static_cast<uint32_t>(bits);
+  res.data[1] = static_cast<uint32_t>(bits >> 32);
+  uint32_t ext = (res.sign ? UINT32_MAX : 0u);
+  res.size = (res.data[1] != ext ? 2 : (res.data[0] != ext ? 1 : 0));
+  return res;
+}
+
+template <native_integer T>
+big_integer& big_integer::operator+=(T rhs) {
+  return add_native(to_native(rhs), false);
+}
+
+template <native_integer T>
+big_integer& big_integer::operator-=(T rhs) {
+  return add_native(to_native(rhs), true);
+}
+
+template <native_integer T>
+big_integer& big_integer::operator*=(T rhs) {
+  return mul_native(to_native(rhs));
+}
+
+template <native_integer T>
+big_integer& big_integer::operator/=(T rhs) {
+  return div_native(to_native(rhs), true);
+}
+
+template <native_integer T>
+big_integer& big_integer::operator%=(T rhs) {
+  return div_native(to_native(rhs), false);
+}
+
+template <native_integer T>
+big_integer operator+(big_integer a, T b) {
+  return a += b;
+}
+
+template <native_integer T>
+big_integer operator+(T a, big_integer b) {
+  return b += a;
+}
+
+template <native_integer T>
+big_integer operator-(big_integer a, T b) {
+  return a -= b;
+}
+
+template <native_integer T>
+big_integer operator-(T a, big_integer b) {
+  b.negate();
+  return b += a;
+}
+
+template <native_integer T>
+big_integer operator*(big_integer a, T b) {
+  return a *= b;
+}
+
+template <native_integer T>
+big_integer operator*(T a, big_integer b) {
+  return b *= a;
+}
+
+template <native_integer T>
+big_integer operator/(big_integer a, T b) {
+  return a /= b;
+}
+
+template <native_integer T>
+big_integer operator%(big_integer a, T b) {
+  return a %= b;
+}
+
+big_integer abs(big_integer a);
+// non-negative, gcd(0, 0) = 0
+big_integer gcd(big_integer a, big_integer b);
+// floor(sqrt(a))
+big_integer isqrt(big_integer const& a);
+
 bool operator==(big_integer const& a, big_integer const& b);
 bool operator!=(big_integer const& a, big_integer const& b);
 bool operator<(big_integer const& a, big_integer const& b);
@@ -97,5 +300,135 @@ bool operator>(big_integer const& a, big_integer const& b);
 bool operator<=(big_integer const& a, big_integer const& b);
 bool operator>=(big_integer const& a, big_integer const& b);
 
+template <native_integer T>
+bool operator==(big_integer const& a, T b) {
+  return a.compare_native(big_integer::to_native(b)) == 0;
+}
+
+template <native_integer T>
+bool operator!=(big_integer const& a, T b) {
+  return !(a == b);
+}
+
+template <native_integer T>
+bool operator<(big_integer const& a, T b) {
+  return a.compare_native(big_integer::to_native(b)) < 0;
+}
+
+template <native_integer T>
+bool operator>(big_integer const& a, T b) {
+  return a.compare_native(big_integer::to_native(b)) > 0;
+}
+
+template <native_integer T>
+bool operator<=(big_integer const& a, T b) {
+  return !(a > b);
+}
+
+template <native_integer T>
+bool operator>=(big_integer const& a, T b) {
+  return !(a < b);
+}
+
+template <native_integer T>
+bool operator==(T a, big_integer const& b) {
+  return b == a;
+}
+
+template <native_integer T>
+bool operator!=(T a, big_integer const& b) {
+  return b != a;
+}
+
+template <native_integer T>
+bool operator<(T a, big_integer const& b) {
+  return b > a;
+}
+
+template <native_integer T>
+bool operator>(T a, big_integer const& b) {
+  return b < a;
+}
+
+template <native_integer T>
+bool operator<=(T a, big_integer const& b) {
+  return b >= a;
+}
+
+template <native_integer T>
+bool operator>=(T a, big_integer const& b) {
+  return b <= a;
+}
+
 std::string to_string(big_integer const& a);
+// bases 2 to 36, digits past 9 are lowercase letters
+std::string to_string(big_integer const& a, int base);
+big_integer from_string(std::string_view str, int base = 10);
+// magnitude given as little-endian 32-bit limbs
+big_integer from_limbs(uint32_t const* limbs, size_t size,
+                       bool negative = false);
+// little-endian limbs of the absolute value without leading zeros
+std::vector<uint32_t> to_limbs(big_integer const& a);
+// honors std::hex, std::oct, std::uppercase and std::showbase
 std::ostream& operator<<(std::ostream& s, big_integer const& a);
+// reads an optionally signed number, honors std::hex and std::oct
+std::istream& operator>>(std::istream& s, big_integer& a);
+// reads the whole file in fixed-size chunks, surrounding whitespace is
+// allowed
+big_integer read_big_integer(int fd, int base = 10);
+
+template <>
+struct std::hash<big_integer> {
+  size_t operator()(big_integer const& a) const noexcept {
+    return a.hash();
+  }
+};
+
+#ifdef __cpp_lib_format
+// {}, {:d}, {:x}, {:X}, {:o}, {:b}
+template <>
+struct std::formatter<big_integer> {
+  constexpr auto parse(std::format_parse_context& ctx) {
+    auto it = ctx.begin();
+    if (it != ctx.end() && *it != '}') {
+      switch (*it++) {
+      case 'd':
+        base = 10;
+        break;
+      case 'x':
+        base = 16;
+        break;
+      case 'X':
+        base = 16;
+        uppercase = true;
+        break;
+      case 'o':
+        base = 8;
+        break;
+      case 'b':
+        base = 2;
+        break;
+      default:
+        throw std::format_error("Unsupported big_integer format");
+      }
+    }
+    if (it != ctx.end() && *it != '}') {
+      throw std::format_error("Unsupported big_integer format");
+    }
+    return it;
+  }
+
+  auto format(big_integer const& a, std::format_context& ctx) const {
+    std::string str = to_string(a, base);
+    if (uppercase) {
+      for (char& c : str) {
+        c = static_cast<char>(std::toupper(c));
+      }
+    }
+    return std::copy(str.begin(), str.end(), ctx.out());
+  }
+
+  int base = 10;
+  bool uppercase = false;
+};
+#endif
@@ -0,0 +1,228 @@
+#include "big_integer_batch.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+// batches estimated below this many limb operations run on the caller
+constexpr size_t SERIAL_COST = 1 << 16;
+// chunks per thread, so that a worker done early takes over the rest
+constexpr size_t CHUNKS_PER_THREAD = 8;
+
+// Helper threads for the batch operations. A batch is posted as a job that
+// lives on the caller's stack: the helpers that see it join, claim chunk
+// indices from its counter alongside the caller, and keep the first
+// exception. Before returning, the caller retracts the job and waits for
+// every helper that joined to leave, so the job never outlives its frame.
+class batch_workers {
+public:
+  batch_workers() {
+    size_t n = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    for (size_t i = 0; i < n; ++i) {
+      helpers_.emplace_back([this] { help(); });
+    }
+  }
+
+  ~batch_workers() {
+    {
+      std::lock_guard lock(mutex_);
+      stop_ = true;
+    }
+    posted_.notify_all();
+    for (std::thread& t : helpers_) {
+      t.join();
+    }
+  }
+
+  batch_workers(batch_workers const&) = delete;
+  batch_workers& operator=(batch_workers const&) = delete;
+
+  // the caller counts as one
+  size_t threads() const {
+    return helpers_.size() + 1;
+  }
+
+  // calls f(i) for every i < chunks and rethrows the first exception once
+  // all of them are done; batches from several threads run one at a time
+  template <typename F>
+  void run(size_t chunks, F const& f) {
+    std::lock_guard batch_lock(batch_mutex_);
+    job j;
+    j.chunks = chunks;
+    j.context = &f;
+    j.call = [](void const* context, size_t i) {
+      (*static_cast<F const*>(context))(i);
+    };
+    {
+      std::lock_guard lock(mutex_);
+      job_ = &j;
+      ++posted_count_;
+    }
+    posted_.notify_all();
+    work_on(j);
+    {
+      std::unique_lock lock(mutex_);
+      job_ = nullptr;
+      left_.wait(lock, [&] { return joined_ == 0; });
+    }
+    if (j.error) {
+      std::rethrow_exception(j.error);
+    }
+  }
+
+private:
+  struct job {
+    size_t chunks = 0;
+    void const* context = nullptr;
+    void (*call)(void const*, size_t) = nullptr;
+    std::atomic<size_t> next {0};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+  };
+
+  std::vector<std::thread> helpers_;
+  std::mutex batch_mutex_;
+  std::mutex mutex_;
+  std::condition_variable posted_;
+  std::condition_variable left_;
+  job* job_ = nullptr;
+  size_t posted_count_ = 0;
+  size_t joined_ = 0;
+  bool stop_ = false;
+
+  static void work_on(job& j) {
+    for (size_t i; (i = j.next.fetch_add(1)) < j.chunks;) {
+      try {
+        j.call(j.context, i);
+      } catch (...) {
+        std::lock_guard lock(j.error_mutex);
+        if (!j.error) {
+          j.error = std::current_exception();
+        }
+      }
+    }
+  }
+
+  void help() {
+    size_t seen = 0;
+    while (true) {
+      job* j;
+      {
+        std::unique_lock lock(mutex_);
+        posted_.wait(lock, [&] {
+          return stop_ || (job_ != nullptr && posted_count_ != seen);
+        });
+        if (stop_) {
+          return;
+        }
+        seen = posted_count_;
+        j = job_;
+        ++joined_;
+      }
+      work_on(*j);
+      std::lock_guard lock(mutex_);
+      if (--joined_ == 0) {
+        left_.notify_all();
+      }
+    }
+  }
+};
+
+batch_workers& workers() {
+  static batch_workers instance;
+  return instance;
+}
+
+// limbs of the two's complement representation, rounded up
+size_t limbs(big_integer const& a) {
+  return a.bit_length() / 32 + 1;
+}
+
+// cost(x, y) estimates the work and result(x, y) bounds the limbs of the
+// result for operands of x and y limbs
+template <typename Cost, typename Result, typename Op>
+void batch(std::vector<big_integer>& out, std::vector<big_integer> const& a,
+           std::vector<big_integer> const& b, Cost cost, Result result,
+           Op op) {
+  if (a.size() != b.size()) {
+    throw std::invalid_argument("Batch operands differ in size");
+  }
+  size_t n = a.size();
+  // resizing out would move the elements of a or b it aliases
+  if (&out != &a && &out != &b) {
+    out.resize(n);
+  }
+  auto apply = [&](size_t i) {
+    big_integer& r = out[i];
+    if (&r == &b[i] && &r != &a[i]) {
+      big_integer t = a[i];
+      op(t, b[i]);
+      r = std::move(t);
+    } else {
+      if (&r != &a[i]) {
+        // a fresh element gets its final size at once, a reused one keeps
+        // its limbs
+        r.reserve(result(limbs(a[i]), limbs(b[i])));
+        r = a[i];
+      }
+      op(r, b[i]);
+    }
+  };
+  // prefix sums of the estimated costs, cut into chunks of equal cost
+  std::vector<size_t> prefix(n + 1);
+  for (size_t i = 0; i < n; ++i) {
+    prefix[i + 1] = prefix[i] + cost(limbs(a[i]), limbs(b[i]));
+  }
+  size_t total = prefix[n];
+  batch_workers& p = workers();
+  if (total < SERIAL_COST || p.threads() == 1) {
+    for (size_t i = 0; i < n; ++i) {
+      apply(i);
+    }
+    return;
+  }
+  size_t chunks = std::min(n, p.threads() * CHUNKS_PER_THREAD);
+  std::vector<size_t> bounds(chunks + 1);
+  for (size_t c = 1; c < chunks; ++c) {
+    size_t target = total / chunks * c;
+    bounds[c] = std::lower_bound(prefix.begin(), prefix.end(), target) -
+                prefix.begin();
+  }
+  bounds[chunks] = n;
+  p.run(chunks, [&](size_t c) {
+    for (size_t i = bounds[c]; i < bounds[c + 1]; ++i) {
+      apply(i);
+    }
+  });
+}
+} // namespace
+
+void batch_add(std::vector<big_integer>& out, std::vector<big_integer> const& a,
+               std::vector<big_integer> const& b) {
+  batch(
+      out, a, b, [](size_t x, size_t y) { return std::max(x, y); },
+      [](size_t x, size_t y) { return std::max(x, y) + 1; },
+      [](big_integer& r, big_integer const& y) { r += y; });
+}
+
+void batch_mul(std::vector<big_integer>& out, std::vector<big_integer> const& a,
+               std::vector<big_integer> const& b) {
+  batch(
+      out, a, b, [](size_t x, size_t y) { return x * y + x + y; },
+      [](size_t x, size_t y) { return x + y; },
+      [](big_integer& r, big_integer const& y) { r *= y; });
+}
+
+void batch_mod(std::vector<big_integer>& out, std::vector<big_integer> const& a,
+               std::vector<big_integer> const& b) {
+  batch(
+      out, a, b,
+      [](size_t x, size_t y) { return (x < y ? x : (x - y + 1) * y + x); },
+      [](size_t x, size_t) { return x; },
+      [](big_integer& r, big_integer const& y) { r %= y; });
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "big_integer.h"
+#include <vector>
+
+// Elementwise out[i] = a[i] op b[i] over independent operand pairs, spread
+// across a shared pool of worker threads. Work is cut into chunks of about
+// equal estimated cost (limb counts for sums, their products for products
+// and remainders), which workers take in turn. out is resized to the
+// operand count and may be a or b; elements it already holds are written in
+// place, so reusing one out vector across batches keeps their limbs
+// allocated. Operand vectors of different sizes throw
+// std::invalid_argument.
+void batch_add(std::vector<big_integer>& out, std::vector<big_integer> const& a,
+               std::vector<big_integer> const& b);
+void batch_mul(std::vector<big_integer>& out, std::vector<big_integer> const& a,
+               std::vector<big_integer> const& b);
+void batch_mod(std::vector<big_integer>& out, std::vector<big_integer> const& a,
+               std::vector<big_integer> const& b);
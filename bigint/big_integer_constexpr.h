@@ -0,0 +1,252 @@
+#pragma once
+
+#include "big_integer.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+// Non-negative integer of at most N limbs whose arithmetic is usable in
+// constant expressions, so tables of large constants can be computed at
+// compile time and converted to big_integer without any arithmetic:
+//
+//   constexpr auto F = factorial<20>(100);
+//   big_integer f = F.to_big_integer();
+//
+// Exceeding the capacity throws std::overflow_error, which in a constant
+// expression turns into a compile error.
+template <size_t N>
+struct fixed_integer {
+  constexpr fixed_integer() = default;
+
+  constexpr fixed_integer(uint64_t a) {
+    while (a != 0) {
+      push(static_cast<uint32_t>(a));
+      a >>= 32;
+    }
+  }
+
+  constexpr explicit fixed_integer(std::string_view str) {
+    if (str.empty()) {
+      throw std::invalid_argument("Find empty string");
+    }
+    for (char c : str) {
+      if (c < '0' || c > '9') {
+        throw std::invalid_argument(std::string("Expected digit, find: ") + c);
+      }
+      mul_small(10);
+      add_small(c - '0');
+    }
+  }
+
+  constexpr fixed_integer& operator+=(fixed_integer const& rhs) {
+    uint64_t carry = 0;
+    size_t n = (size_ > rhs.size_ ? size_ : rhs.size_);
+    for (size_t i = 0; i < n; ++i) {
+      carry += static_cast<uint64_t>(get_digit(i)) + rhs.get_digit(i);
+      set(i, static_cast<uint32_t>(carry));
+      carry >>= 32;
+    }
+    if (carry != 0) {
+      push(static_cast<uint32_t>(carry));
+    }
+    return *this;
+  }
+
+  constexpr fixed_integer& operator-=(fixed_integer const& rhs) {
+    if (*this < rhs) {
+      throw std::invalid_argument("fixed_integer is non-negative");
+    }
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < size_; ++i) {
+      uint64_t diff = static_cast<uint64_t>(data_[i]) - rhs.get_digit(i) - borrow;
+      data_[i] = static_cast<uint32_t>(diff);
+      borrow = (diff >> 32) != 0;
+    }
+    trim();
+    return *this;
+  }
+
+  constexpr fixed_integer& operator*=(fixed_integer const& rhs) {
+    if (size_ == 0 || rhs.size_ == 0) {
+      *this = fixed_integer();
+      return *this;
+    }
+    if (size_ + rhs.size_ - 1 > N) {
+      throw std::overflow_error("fixed_integer overflow");
+    }
+    std::array<uint32_t, N + 1> res {};
+    for (size_t i = 0; i < size_; ++i) {
+      uint64_t carry = 0;
+      for (size_t j = 0; j < rhs.size_; ++j) {
+        carry += static_cast<uint64_t>(data_[i]) * rhs.data_[j] + res[i + j];
+        res[i + j] = static_cast<uint32_t>(carry);
+        carry >>= 32;
+      }
+      res[i + rhs.size_] = static_cast<uint32_t>(carry);
+    }
+    size_t n = size_ + rhs.size_;
+    if (n > N && res[N] != 0) {
+      throw std::overflow_error("fixed_integer overflow");
+    }
+    size_ = (n > N ? N : n);
+    for (size_t i = 0; i < size_; ++i) {
+      data_[i] = res[i];
+    }
+    trim();
+    return *this;
+  }
+
+  constexpr fixed_integer& add_small(uint32_t rhs) {
+    uint64_t carry = rhs;
+    for (size_t i = 0; i < size_ && carry != 0; ++i) {
+      carry += data_[i];
+      data_[i] = static_cast<uint32_t>(carry);
+      carry >>= 32;
+    }
+    if (carry != 0) {
+      push(static_cast<uint32_t>(carry));
+    }
+    return *this;
+  }
+
+  constexpr fixed_integer& mul_small(uint32_t rhs) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < size_; ++i) {
+      carry += static_cast<uint64_t>(data_[i]) * rhs;
+      data_[i] = static_cast<uint32_t>(carry);
+      carry >>= 32;
+    }
+    if (carry != 0) {
+      push(static_cast<uint32_t>(carry));
+    }
+    trim();
+    return *this;
+  }
+
+  // returns the remainder
+  constexpr uint32_t div_small(uint32_t rhs) {
+    uint64_t rem = 0;
+    for (size_t i = size_; i-- > 0;) {
+      rem = (rem << 32) | data_[i];
+      data_[i] = static_cast<uint32_t>(rem / rhs);
+      rem %= rhs;
+    }
+    trim();
+    return static_cast<uint32_t>(rem);
+  }
+
+  friend constexpr fixed_integer operator+(fixed_integer a,
+                                           fixed_integer const& b) {
+    return a += b;
+  }
+
+  friend constexpr fixed_integer operator-(fixed_integer a,
+                                           fixed_integer const& b) {
+    return a -= b;
+  }
+
+  friend constexpr fixed_integer operator*(fixed_integer a,
+                                           fixed_integer const& b) {
+    return a *= b;
+  }
+
+  friend constexpr bool operator==(fixed_integer const& a,
+                                   fixed_integer const& b) {
+    if (a.size_ != b.size_) {
+      return false;
+    }
+    for (size_t i = 0; i < a.size_; ++i) {
+      if (a.data_[i] != b.data_[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  friend constexpr bool operator<(fixed_integer const& a,
+                                  fixed_integer const& b) {
+    if (a.size_ != b.size_) {
+      return a.size_ < b.size_;
+    }
+    for (size_t i = a.size_; i-- > 0;) {
+      if (a.data_[i] != b.data_[i]) {
+        return a.data_[i] < b.data_[i];
+      }
+    }
+    return false;
+  }
+
+  // little-endian limbs without leading zeros
+  constexpr uint32_t const* limbs() const {
+    return data_.data();
+  }
+
+  constexpr size_t size() const {
+    return size_;
+  }
+
+  big_integer to_big_integer() const {
+    return from_limbs(data_.data(), size_);
+  }
+
+private:
+  constexpr uint32_t get_digit(size_t i) const {
+    return (i < size_ ? data_[i] : 0);
+  }
+
+  constexpr void set(size_t i, uint32_t value) {
+    if (i >= size_) {
+      push(value);
+    } else {
+      data_[i] = value;
+    }
+  }
+
+  constexpr void push(uint32_t value) {
+    if (size_ == N) {
+      throw std::overflow_error("fixed_integer overflow");
+    }
+    data_[size_++] = value;
+  }
+
+  constexpr void trim() {
+    while (size_ > 0 && data_[size_ - 1] == 0) {
+      --size_;
+    }
+  }
+
+  std::array<uint32_t, N> data_ {};
+  size_t size_ = 0;
+};
+
+template <size_t N>
+constexpr fixed_integer<N> pow(fixed_integer<N> base, uint64_t exp) {
+  fixed_integer<N> res = 1;
+  while (exp != 0) {
+    if (exp & 1) {
+      res *= base;
+    }
+    exp >>= 1;
+    if (exp != 0) {
+      base *= base;
+    }
+  }
+  return res;
+}
+
+template <size_t N>
+constexpr fixed_integer<N> factorial(uint32_t n) {
+  fixed_integer<N> res = 1;
+  for (uint32_t i = 2; i <= n; ++i) {
+    res.mul_small(i);
+  }
+  return res;
+}
+
+// number of limbs enough for any value with the given number of decimal
+// digits, log2(10) < 3.33
+constexpr size_t decimal_limbs(size_t digits) {
+  return (digits * 333 / 100 + 1) / 32 + 1;
+}
@@ -0,0 +1,318 @@
+#pragma once
+
+#include "big_integer.h"
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+
+// Opt-in expression templates for big_integer:
+//
+//   using bigint_expr::ref;
+//   bigint_expr::assign(r, (ref(a) + ref(b) - ref(c)) * ref(d) % ref(m));
+//
+// Chains of + and - are evaluated in a single carry pass, products and
+// quotients are evaluated in the destination's storage when it is safe,
+// and `x = x op y` is performed in place.
+namespace bigint_expr {
+
+struct operand {
+  big_integer const& value;
+};
+
+template <typename L, typename R, bool Negate>
+struct sum {
+  L lhs;
+  R rhs;
+};
+
+template <typename L, typename R, typename Op>
+struct binary {
+  L lhs;
+  R rhs;
+};
+
+struct multiplies {
+  static void apply(big_integer& a, big_integer const& b) {
+    a *= b;
+  }
+};
+
+struct divides {
+  static void apply(big_integer& a, big_integer const& b) {
+    a /= b;
+  }
+};
+
+struct modulus {
+  static void apply(big_integer& a, big_integer const& b) {
+    a %= b;
+  }
+};
+
+template <typename T>
+struct is_expression : std::false_type {};
+
+template <>
+struct is_expression<operand> : std::true_type {};
+
+template <typename L, typename R, bool Negate>
+struct is_expression<sum<L, R, Negate>> : std::true_type {};
+
+template <typename L, typename R, typename Op>
+struct is_expression<binary<L, R, Op>> : std::true_type {};
+
+template <typename T>
+concept expression = is_expression<std::remove_cvref_t<T>>::value;
+
+template <typename T>
+concept integer = std::same_as<std::remove_cvref_t<T>, big_integer>;
+
+// operands are held by reference, so a temporary would dangle
+template <typename T>
+concept temporary = integer<T> && !std::is_lvalue_reference_v<T>;
+
+inline operand ref(big_integer const& a) {
+  return {a};
+}
+
+operand ref(big_integer&&) = delete;
+
+namespace detail {
+
+template <typename E>
+struct traits {
+  // number of terms in the flattened +/- chain
+  static constexpr size_t terms = 1;
+  // number of terms that have to be materialized
+  static constexpr size_t temporaries = 1;
+};
+
+template <>
+struct traits<operand> {
+  static constexpr size_t terms = 1;
+  static constexpr size_t temporaries = 0;
+};
+
+template <typename L, typename R, bool Negate>
+struct traits<sum<L, R, Negate>> {
+  static constexpr size_t terms = traits<L>::terms + traits<R>::terms;
+  static constexpr size_t temporaries =
+      traits<L>::temporaries + traits<R>::temporaries;
+};
+
+inline bool references(operand const& e, big_integer const& x) {
+  return &e.value == &x;
+}
+
+template <typename L, typename R, bool Negate>
+bool references(sum<L, R, Negate> const& e, big_integer const& x) {
+  return references(e.lhs, x) || references(e.rhs, x);
+}
+
+template <typename L, typename R, typename Op>
+bool references(binary<L, R, Op> const& e, big_integer const& x) {
+  return references(e.lhs, x) || references(e.rhs, x);
+}
+
+// whether x is used anywhere except the leftmost term of the chain
+template <typename E>
+bool references_tail(E const&, big_integer const&) {
+  return false;
+}
+
+template <typename L, typename R, bool Negate>
+bool references_tail(sum<L, R, Negate> const& e, big_integer const& x) {
+  return references_tail(e.lhs, x) || references(e.rhs, x);
+}
+
+template <typename E>
+E const& leftmost(E const& e) {
+  return e;
+}
+
+template <typename L, typename R, bool Negate>
+auto const& leftmost(sum<L, R, Negate> const& e) {
+  return leftmost(e.lhs);
+}
+
+template <size_t N, size_t T>
+struct chain {
+  std::array<big_integer const*, N> terms {};
+  std::array<bool, N> negative {};
+  std::array<big_integer, T> temporaries;
+  size_t size = 0;
+  size_t used = 0;
+};
+
+} // namespace detail
+
+inline void assign(big_integer& dest, operand const& e);
+
+template <typename L, typename R, bool Negate>
+void assign(big_integer& dest, sum<L, R, Negate> const& e);
+
+template <typename L, typename R, typename Op>
+void assign(big_integer& dest, binary<L, R, Op> const& e);
+
+template <expression E>
+big_integer evaluate(E const& e) {
+  big_integer res;
+  assign(res, e);
+  return res;
+}
+
+namespace detail {
+
+template <size_t N, size_t T>
+void collect(operand const& e, bool negative, chain<N, T>& c,
+             big_integer const* head) {
+  c.terms[c.size] = (head != nullptr ? head : &e.value);
+  c.negative[c.size++] = negative;
+}
+
+template <typename E, size_t N, size_t T>
+void collect(E const& e, bool negative, chain<N, T>& c,
+             big_integer const* head) {
+  if (head == nullptr) {
+    big_integer& tmp = c.temporaries[c.used++];
+    assign(tmp, e);
+    head = &tmp;
+  }
+  c.terms[c.size] = head;
+  c.negative[c.size++] = negative;
+}
+
+template <typename L, typename R, bool Negate, size_t N, size_t T>
+void collect(sum<L, R, Negate> const& e, bool negative, chain<N, T>& c,
+             big_integer const* head) {
+  collect(e.lhs, negative, c, head);
+  collect(e.rhs, negative ^ Negate, c, nullptr);
+}
+
+template <typename Op>
+void apply(big_integer& dest, operand const& rhs) {
+  Op::apply(dest, rhs.value);
+}
+
+template <typename Op, typename E>
+void apply(big_integer& dest, E const& rhs) {
+  big_integer value = evaluate(rhs);
+  Op::apply(dest, value);
+}
+
+inline operand as_expression(big_integer const& a) {
+  return {a};
+}
+
+template <expression E>
+E const& as_expression(E const& e) {
+  return e;
+}
+
+} // namespace detail
+
+inline void assign(big_integer& dest, operand const& e) {
+  if (&e.value != &dest) {
+    dest = e.value;
+  }
+}
+
+template <typename L, typename R, bool Negate>
+void assign(big_integer& dest, sum<L, R, Negate> const& e) {
+  using traits = detail::traits<sum<L, R, Negate>>;
+  detail::chain<traits::terms, traits::temporaries> c;
+  big_integer const* head = nullptr;
+  auto const& first = detail::leftmost(e);
+  if constexpr (!std::is_same_v<std::remove_cvref_t<decltype(first)>,
+                                operand>) {
+    if (!detail::references_tail(e, dest)) {
+      assign(dest, first);
+      head = &dest;
+    }
+  }
+  detail::collect(e, false, c, head);
+  dest.assign_sum(c.terms.data(), c.negative.data(), c.size);
+}
+
+template <typename L, typename R, typename Op>
+void assign(big_integer& dest, binary<L, R, Op> const& e) {
+  if (!detail::references(e.rhs, dest)) {
+    assign(dest, e.lhs);
+    detail::apply<Op>(dest, e.rhs);
+  } else {
+    big_integer rhs = evaluate(e.rhs);
+    assign(dest, e.lhs);
+    Op::apply(dest, rhs);
+  }
+}
+
+template <typename L, typename R>
+concept arguments = (expression<L> || expression<R>) &&
+                    (expression<L> || integer<L>) &&
+                    (expression<R> || integer<R>);
+
+template <typename L, typename R>
+concept temporary_arguments =
+    arguments<L, R> && (temporary<L> || temporary<R>);
+
+template <typename T>
+using as_expression_t =
+    std::remove_cvref_t<decltype(detail::as_expression(std::declval<T>()))>;
+
+template <typename L, typename R>
+requires temporary_arguments<L, R>
+auto operator+(L&& lhs, R&& rhs) = delete;
+
+template <typename L, typename R>
+requires arguments<L, R>
+auto operator+(L const& lhs, R const& rhs) {
+  return sum<as_expression_t<L>, as_expression_t<R>, false> {
+      detail::as_expression(lhs), detail::as_expression(rhs)};
+}
+
+template <typename L, typename R>
+requires temporary_arguments<L, R>
+auto operator-(L&& lhs, R&& rhs) = delete;
+
+template <typename L, typename R>
+requires arguments<L, R>
+auto operator-(L const& lhs, R const& rhs) {
+  return sum<as_expression_t<L>, as_expression_t<R>, true> {
+      detail::as_expression(lhs), detail::as_expression(rhs)};
+}
+
+template <typename L, typename R>
+requires temporary_arguments<L, R>
+auto operator*(L&& lhs, R&& rhs) = delete;
+
+template <typename L, typename R>
+requires arguments<L, R>
+auto operator*(L const& lhs, R const& rhs) {
+  return binary<as_expression_t<L>, as_expression_t<R>, multiplies> {
+      detail::as_expression(lhs), detail::as_expression(rhs)};
+}
+
+template <typename L, typename R>
+requires temporary_arguments<L, R>
+auto operator/(L&& lhs, R&& rhs) = delete;
+
+template <typename L, typename R>
+requires arguments<L, R>
+auto operator/(L const& lhs, R const& rhs) {
+  return binary<as_expression_t<L>, as_expression_t<R>, divides> {
+      detail::as_expression(lhs), detail::as_expression(rhs)};
+}
+
+template <typename L, typename R>
+requires temporary_arguments<L, R>
+auto operator%(L&& lhs, R&& rhs) = delete;
+
+template <typename L, typename R>
+requires arguments<L, R>
+auto operator%(L const& lhs, R const& rhs) {
+  return binary<as_expression_t<L>, as_expression_t<R>, modulus> {
+      detail::as_expression(lhs), detail::as_expression(rhs)};
+}
+
+} // namespace bigint_expr
@@ -0,0 +1,64 @@
+#include "big_integer_mmap.h"
+#include <cstdlib>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utility>
+
+namespace bigint_mmap {
+namespace {
+struct settings {
+  std::mutex lock;
+  std::string directory;
+};
+
+settings& global() {
+  static settings s {{}, [] {
+    char const* tmp = std::getenv("TMPDIR");
+    return std::string(tmp != nullptr && *tmp != '\0' ? tmp : "/tmp");
+  }()};
+  return s;
+}
+} // namespace
+
+void set_directory(std::string path) {
+  settings& s = global();
+  std::lock_guard lock(s.lock);
+  s.directory = std::move(path);
+}
+
+std::string directory() {
+  settings& s = global();
+  std::lock_guard lock(s.lock);
+  return s.directory;
+}
+
+namespace detail {
+void* map(size_t bytes) {
+  std::string path = directory() + "/bigint-XXXXXX";
+  int fd = mkstemp(path.data());
+  if (fd < 0) {
+    throw std::bad_alloc();
+  }
+  // the file lives as long as the mapping
+  unlink(path.c_str());
+  // reserving the blocks turns a full disk into bad_alloc here instead of
+  // SIGBUS on a later write
+  if (posix_fallocate(fd, 0, static_cast<off_t>(bytes)) != 0) {
+    close(fd);
+    throw std::bad_alloc();
+  }
+  void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void unmap(void* p, size_t bytes) noexcept {
+  munmap(p, bytes);
+}
+} // namespace detail
+} // namespace bigint_mmap
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string>
+
+// File-backed limb storage for numbers that do not fit in memory. With
+// -DBIGINT_MMAP every big_integer keeps its limbs, and the multiplication
+// transform its buffers, in mapped_allocator: large blocks live in unlinked
+// temporary files mapped into the address space, so they are paged through
+// the page cache instead of failing with std::bad_alloc. Without the flag
+// limb_allocator is std::allocator and nothing changes.
+namespace bigint_mmap {
+#ifdef BIGINT_MMAP
+constexpr bool enabled = true;
+#else
+constexpr bool enabled = false;
+#endif
+
+// blocks of at least this many bytes are backed by files, smaller ones come
+// from operator new
+constexpr size_t MAP_THRESHOLD = size_t(1) << 20;
+
+// where the backing files are created, $TMPDIR or /tmp by default; the
+// space is reserved on allocation, so a full disk throws std::bad_alloc
+void set_directory(std::string path);
+std::string directory();
+
+namespace detail {
+void* map(size_t bytes);
+void unmap(void* p, size_t bytes) noexcept;
+} // namespace detail
+
+template <typename T>
+struct mapped_allocator {
+  using value_type = T;
+
+  mapped_allocator() = default;
+  template <typename U>
+  mapped_allocator(mapped_allocator<U> const&) noexcept {}
+
+  T* allocate(size_t n) {
+    if (n > SIZE_MAX / sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+    if (n * sizeof(T) < MAP_THRESHOLD) {
+      return std::allocator<T>().allocate(n);
+    }
+    return static_cast<T*>(detail::map(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t n) noexcept {
+    if (n * sizeof(T) < MAP_THRESHOLD) {
+      std::allocator<T>().deallocate(p, n);
+    } else {
+      detail::unmap(p, n * sizeof(T));
+    }
+  }
+};
+
+template <typename T, typename U>
+bool operator==(mapped_allocator<T> const&, mapped_allocator<U> const&) {
+  return true;
+}
+
+#ifdef BIGINT_MMAP
+template <typename T>
+using limb_allocator = mapped_allocator<T>;
+#else
+template <typename T>
+using limb_allocator = std::allocator<T>;
+#endif
+} // namespace bigint_mmap
@@ -0,0 +1,271 @@
+#include "big_integer_ntt.h"
+#include "big_integer_mmap.h"
+#include <algorithm>
+#include <bit>
+#include <vector>
+
+namespace bigint_ntt {
+namespace {
+using uint128_t = unsigned __int128;
+using buffer = std::vector<uint64_t, bigint_mmap::limb_allocator<uint64_t>>;
+
+// columns gathered per block of the column pass, enough for every row to
+// contribute whole pages
+constexpr size_t BLOCK_COLUMNS = 512;
+
+// arithmetic modulo p < 2^62, products in Montgomery form
+struct field {
+  uint64_t p;
+  // generator of the multiplicative group
+  uint64_t g;
+  // -p^(-1) mod 2^64
+  uint64_t ninv;
+  // 2^128 mod p
+  uint64_t r2;
+
+  constexpr field(uint64_t p, uint64_t g) : p(p), g(g), ninv(0), r2(0) {
+    uint64_t inv = p;
+    for (int i = 0; i < 5; ++i) {
+      inv *= 2 - p * inv;
+    }
+    ninv = -inv;
+    uint64_t r = -p % p;
+    r2 = static_cast<uint64_t>(static_cast<uint128_t>(r) * r % p);
+  }
+
+  // a * b / 2^64 mod p
+  uint64_t mul(uint64_t a, uint64_t b) const {
+    uint128_t t = static_cast<uint128_t>(a) * b;
+    uint64_t m = static_cast<uint64_t>(t) * ninv;
+    auto u = static_cast<uint64_t>((t + static_cast<uint128_t>(m) * p) >> 64);
+    return (u >= p ? u - p : u);
+  }
+
+  uint64_t add(uint64_t a, uint64_t b) const {
+    uint64_t s = a + b;
+    return (s >= p ? s - p : s);
+  }
+
+  uint64_t sub(uint64_t a, uint64_t b) const {
+    return (a >= b ? a - b : a + p - b);
+  }
+
+  // Montgomery form of a
+  uint64_t to(uint64_t a) const {
+    return mul(a, r2);
+  }
+
+  // a and the result in Montgomery form
+  uint64_t pow(uint64_t a, uint64_t e) const {
+    uint64_t res = to(1);
+    for (; e != 0; e >>= 1) {
+      if (e & 1) {
+        res = mul(res, a);
+      }
+      a = mul(a, a);
+    }
+    return res;
+  }
+
+  // Montgomery form of a primitive root of unity of order len
+  uint64_t root(size_t len, bool inverse) const {
+    uint64_t w = pow(to(g), (p - 1) / len);
+    return (inverse ? pow(w, len - 1) : w);
+  }
+};
+
+// 2^46 divides p - 1 for each of them
+constexpr field FIELDS[3] = {{0x3fff840000000001, 19},
+                             {0x3fffbe0000000001, 3},
+                             {0x3fffc00000000001, 11}};
+
+// the powers w^j, j < len / 2, of a root of order len
+buffer powers(field const& f, size_t len, bool inverse) {
+  buffer res(std::max<size_t>(len / 2, 1));
+  uint64_t w = f.root(len, inverse);
+  res[0] = f.to(1);
+  for (size_t j = 1; j < res.size(); ++j) {
+    res[j] = f.mul(res[j - 1], w);
+  }
+  return res;
+}
+
+// decimation in frequency: natural order in, bit-reversed order out
+void forward(field const& f, uint64_t* a, size_t len, uint64_t const* tw) {
+  for (size_t h = len / 2, step = 1; h != 0; h /= 2, step *= 2) {
+    for (size_t s = 0; s < len; s += 2 * h) {
+      for (size_t j = 0; j < h; ++j) {
+        uint64_t u = a[s + j];
+        uint64_t v = a[s + j + h];
+        a[s + j] = f.add(u, v);
+        a[s + j + h] = f.mul(f.sub(u, v), tw[j * step]);
+      }
+    }
+  }
+}
+
+// decimation in time with the inverse root: bit-reversed order in, natural
+// order out, scaled by len
+void inverse(field const& f, uint64_t* a, size_t len, uint64_t const* tw) {
+  for (size_t h = 1, step = len / 2; h < len; h *= 2, step /= 2) {
+    for (size_t s = 0; s < len; s += 2 * h) {
+      for (size_t j = 0; j < h; ++j) {
+        uint64_t u = a[s + j];
+        uint64_t v = f.mul(a[s + j + h], tw[j * step]);
+        a[s + j] = f.add(u, v);
+        a[s + j + h] = f.sub(u, v);
+      }
+    }
+  }
+}
+
+// Transforms of length rows * columns of x stored row by row. Element
+// (n1, n2) is x[n1 * columns + n2]; the columns are transformed, element
+// (k1, n2) is multiplied by w^(k1 * n2) for the root w of the full length,
+// and then the rows are transformed. The spectrum comes out permuted,
+// which pointwise products do not care about, and the inverse undoes the
+// steps in reverse order.
+struct transform {
+  field const& f;
+  size_t rows;
+  size_t columns;
+  buffer row_roots;
+  buffer column_roots;
+  // w^k1 for the row at each position of the bit-reversed column output
+  buffer twiddles;
+  bool invert;
+
+  transform(field const& f, size_t rows, size_t columns, bool invert)
+      : f(f), rows(rows), columns(columns),
+        row_roots(powers(f, columns, invert)),
+        column_roots(powers(f, rows, invert)), twiddles(rows),
+        invert(invert) {
+    uint64_t w = f.root(rows * columns, invert);
+    int bits = std::countr_zero(rows);
+    for (size_t r = 0; r < rows; ++r) {
+      size_t k1 = 0;
+      for (int i = 0; i < bits; ++i) {
+        k1 |= ((r >> i) & 1) << (bits - 1 - i);
+      }
+      twiddles[r] = f.pow(w, k1);
+    }
+  }
+
+  void run(uint64_t* x) const {
+    if (!invert) {
+      column_pass(x);
+      row_pass(x);
+    } else {
+      row_pass(x);
+      column_pass(x);
+    }
+  }
+
+  void row_pass(uint64_t* x) const {
+    for (size_t r = 0; r < rows; ++r) {
+      if (!invert) {
+        forward(f, x + r * columns, columns, row_roots.data());
+      } else {
+        inverse(f, x + r * columns, columns, row_roots.data());
+      }
+    }
+  }
+
+  void column_pass(uint64_t* x) const {
+    size_t block = std::min(columns, BLOCK_COLUMNS);
+    std::vector<uint64_t> tmp(block * rows);
+    // w^(k1 * n2) for the current column n2
+    std::vector<uint64_t> factor(rows, f.to(1));
+    for (size_t c0 = 0; c0 < columns; c0 += block) {
+      for (size_t r = 0; r < rows; ++r) {
+        uint64_t const* row = x + r * columns + c0;
+        for (size_t b = 0; b < block; ++b) {
+          tmp[b * rows + r] = row[b];
+        }
+      }
+      for (size_t b = 0; b < block; ++b) {
+        uint64_t* column = tmp.data() + b * rows;
+        if (!invert) {
+          forward(f, column, rows, column_roots.data());
+        }
+        for (size_t r = 0; r < rows; ++r) {
+          column[r] = f.mul(column[r], factor[r]);
+          factor[r] = f.mul(factor[r], twiddles[r]);
+        }
+        if (invert) {
+          inverse(f, column, rows, column_roots.data());
+        }
+      }
+      for (size_t r = 0; r < rows; ++r) {
+        uint64_t* row = x + r * columns + c0;
+        for (size_t b = 0; b < block; ++b) {
+          row[b] = tmp[b * rows + r];
+        }
+      }
+    }
+  }
+};
+
+void load(buffer& x, uint32_t const* a, size_t n) {
+  std::fill(std::copy(a, a + n, x.begin()), x.end(), 0);
+}
+} // namespace
+
+void multiply(uint32_t* out, uint32_t const* a, size_t n, uint32_t const* b,
+              size_t m) {
+  size_t len = std::bit_ceil(n + m);
+  size_t rows = size_t(1) << (std::countr_zero(len) / 2);
+  size_t columns = len / rows;
+  bool square = (a == b && n == m);
+  // the product modulo each prime
+  buffer residues[3];
+  buffer y;
+  for (size_t k = 0; k < 3; ++k) {
+    field const& f = FIELDS[k];
+    transform forward(f, rows, columns, false);
+    buffer& x = residues[k];
+    x.resize(len);
+    load(x, a, n);
+    forward.run(x.data());
+    if (!square) {
+      y.resize(len);
+      load(y, b, m);
+      forward.run(y.data());
+    }
+    uint64_t const* z = (square ? x.data() : y.data());
+    for (size_t i = 0; i < len; ++i) {
+      x[i] = f.mul(x[i], z[i]);
+    }
+    transform(f, rows, columns, true).run(x.data());
+  }
+  // the pointwise products and the inverse transform leave a factor of
+  // len / 2^64, removed together with the conversion to plain residues
+  uint64_t scale[3];
+  for (size_t k = 0; k < 3; ++k) {
+    field const& f = FIELDS[k];
+    scale[k] = f.to(f.pow(f.to(len), f.p - 2));
+  }
+  field const& f1 = FIELDS[0];
+  field const& f2 = FIELDS[1];
+  field const& f3 = FIELDS[2];
+  // Garner's constants: p1^(-1) mod p2, p1 mod p3, (p1 p2)^(-1) mod p3
+  uint64_t inv1 = f2.pow(f2.to(f1.p), f2.p - 2);
+  uint64_t p1 = f3.to(f1.p);
+  uint64_t inv12 = f3.pow(f3.mul(f3.to(f1.p), f3.to(f2.p)), f3.p - 2);
+  uint128_t p12 = static_cast<uint128_t>(f1.p) * f2.p;
+  // every coefficient is below min(n, m) * 2^64, so it is recovered exactly
+  // modulo 2^128
+  uint128_t carry = 0;
+  for (size_t i = 0; i < n + m; ++i) {
+    uint64_t r1 = f1.mul(residues[0][i], scale[0]);
+    uint64_t r2 = f2.mul(residues[1][i], scale[1]);
+    uint64_t r3 = f3.mul(residues[2][i], scale[2]);
+    uint64_t t1 = f2.mul(f2.sub(r2, r1), inv1);
+    uint64_t y3 = f3.add(r1, f3.mul(t1, p1));
+    uint64_t t2 = f3.mul(f3.sub(r3, y3), inv12);
+    carry += r1 + static_cast<uint128_t>(f1.p) * t1 + p12 * t2;
+    out[i] = static_cast<uint32_t>(carry);
+    carry >>= 32;
+  }
+}
+} // namespace bigint_ntt
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Multiplication by number theoretic transforms modulo three 62-bit primes,
+// combined by the Chinese remainder theorem. Each transform of length
+// N = rows * columns is done in two blocked passes (Bailey's four-step
+// algorithm without the transposition): column transforms on blocks of
+// whole columns gathered from all rows, then row transforms in place, so
+// large buffers are streamed rather than accessed at page-sized strides.
+namespace bigint_ntt {
+// operands of at least this many limbs each are multiplied by transforms
+constexpr size_t THRESHOLD = 1024;
+
+// out[0, n + m) = a[0, n) * b[0, m) for magnitudes given as little-endian
+// 32-bit limbs; out must not overlap the operands
+void multiply(uint32_t* out, uint32_t const* a, size_t n, uint32_t const* b,
+              size_t m);
+} // namespace bigint_ntt
@@ -0,0 +1,564 @@
+#include "big_integer_prime.h"
+#include <algorithm>
+#include <array>
+#include <random>
+#include <stdexcept>
+
+namespace {
+using residue = montgomery::residue;
+using uint128_t = unsigned __int128;
+
+residue to_words(big_integer const& a, size_t size) {
+  std::vector<uint32_t> limbs = to_limbs(a);
+  residue res(std::max(size, (limbs.size() + 1) / 2));
+  for (size_t i = 0; i < limbs.size(); ++i) {
+    res[i / 2] |= static_cast<uint64_t>(limbs[i]) << (i % 2 * 32);
+  }
+  return res;
+}
+
+big_integer from_words(residue const& a) {
+  std::vector<uint32_t> limbs(a.size() * 2);
+  for (size_t i = 0; i < limbs.size(); ++i) {
+    limbs[i] = static_cast<uint32_t>(a[i / 2] >> (i % 2 * 32));
+  }
+  return from_limbs(limbs.data(), limbs.size());
+}
+
+uint64_t add_words(uint64_t* out, uint64_t const* a, uint64_t const* b,
+                   size_t size) {
+  uint64_t carry = 0;
+  for (size_t i = 0; i < size; ++i) {
+    uint128_t sum = static_cast<uint128_t>(a[i]) + b[i] + carry;
+    out[i] = static_cast<uint64_t>(sum);
+    carry = static_cast<uint64_t>(sum >> 64);
+  }
+  return carry;
+}
+
+uint64_t sub_words(uint64_t* out, uint64_t const* a, uint64_t const* b,
+                   size_t size) {
+  uint64_t borrow = 0;
+  for (size_t i = 0; i < size; ++i) {
+    uint128_t diff = static_cast<uint128_t>(a[i]) - b[i] - borrow;
+    out[i] = static_cast<uint64_t>(diff);
+    borrow = static_cast<uint64_t>(diff >> 64) & 1;
+  }
+  return borrow;
+}
+
+bool less_words(uint64_t const* a, uint64_t const* b, size_t size) {
+  for (size_t i = size; i-- > 0;) {
+    if (a[i] != b[i]) {
+      return a[i] < b[i];
+    }
+  }
+  return false;
+}
+
+bool is_zero_words(residue const& a) {
+  return std::all_of(a.begin(), a.end(), [](uint64_t w) { return w == 0; });
+}
+} // namespace
+
+montgomery::montgomery(big_integer const& modulus) : modulus_(modulus) {
+  if (modulus.is_negative() || modulus.bit_length() < 2 ||
+      to_limbs(modulus)[0] % 2 == 0) {
+    throw std::invalid_argument("Montgomery modulus must be odd and > 1");
+  }
+  n_ = to_words(modulus, 0);
+  // Newton's iteration doubles the correct low bits, n * n = 1 mod 8
+  uint64_t x = n_[0];
+  for (int i = 0; i < 5; ++i) {
+    x *= 2 - n_[0] * x;
+  }
+  inv_ = -x;
+  int bits = static_cast<int>(64 * n_.size());
+  one_ = to_words((big_integer(1) << bits) % modulus, n_.size());
+  r2_ = to_words((big_integer(1) << (2 * bits)) % modulus, n_.size());
+}
+
+size_t montgomery::size() const {
+  return n_.size();
+}
+
+residue const& montgomery::one() const {
+  return one_;
+}
+
+residue montgomery::to_residue(big_integer const& a) const {
+  big_integer r = a % modulus_;
+  if (r.is_negative()) {
+    r += modulus_;
+  }
+  residue res = to_words(r, n_.size());
+  mul(res, res, r2_);
+  return res;
+}
+
+big_integer montgomery::from_residue(residue const& a) const {
+  residue unit(n_.size());
+  unit[0] = 1;
+  mul(unit, a, unit);
+  return from_words(unit);
+}
+
+// coarsely integrated operand scanning: one multiplication row and one
+// reduction row per word of b
+void montgomery::mul(residue& out, residue const& a, residue const& b) const {
+  size_t k = n_.size();
+  // moduli up to 4096 bits keep the accumulator on the stack
+  std::array<uint64_t, 66> stack {};
+  residue heap(k + 2 > stack.size() ? k + 2 : 0);
+  uint64_t* __restrict t = (heap.empty() ? stack.data() : heap.data());
+  uint64_t const* x = a.data();
+  uint64_t const* n = n_.data();
+  for (size_t i = 0; i < k; ++i) {
+    uint64_t y = b[i];
+    uint64_t carry = 0;
+    for (size_t j = 0; j < k; ++j) {
+      uint128_t cur = static_cast<uint128_t>(x[j]) * y + t[j] + carry;
+      t[j] = static_cast<uint64_t>(cur);
+      carry = static_cast<uint64_t>(cur >> 64);
+    }
+    uint128_t top = static_cast<uint128_t>(t[k]) + carry;
+    t[k] = static_cast<uint64_t>(top);
+    t[k + 1] = static_cast<uint64_t>(top >> 64);
+
+    uint64_t m = t[0] * inv_;
+    uint128_t cur = static_cast<uint128_t>(m) * n[0] + t[0];
+    carry = static_cast<uint64_t>(cur >> 64);
+    for (size_t j = 1; j < k; ++j) {
+      cur = static_cast<uint128_t>(m) * n[j] + t[j] + carry;
+      t[j - 1] = static_cast<uint64_t>(cur);
+      carry = static_cast<uint64_t>(cur >> 64);
+    }
+    top = static_cast<uint128_t>(t[k]) + carry;
+    t[k - 1] = static_cast<uint64_t>(top);
+    t[k] = t[k + 1] + static_cast<uint64_t>(top >> 64);
+  }
+  out.resize(k);
+  if (t[k] != 0 || !less_words(t, n, k)) {
+    sub_words(out.data(), t, n, k);
+  } else {
+    std::copy(t, t + k, out.begin());
+  }
+}
+
+void montgomery::add(residue& out, residue const& a, residue const& b) const {
+  size_t k = n_.size();
+  out.resize(k);
+  uint64_t carry = add_words(out.data(), a.data(), b.data(), k);
+  if (carry != 0 || !less_words(out.data(), n_.data(), k)) {
+    sub_words(out.data(), out.data(), n_.data(), k);
+  }
+}
+
+void montgomery::sub(residue& out, residue const& a, residue const& b) const {
+  size_t k = n_.size();
+  out.resize(k);
+  if (sub_words(out.data(), a.data(), b.data(), k) != 0) {
+    add_words(out.data(), out.data(), n_.data(), k);
+  }
+}
+
+void montgomery::half(residue& out, residue const& a) const {
+  size_t k = n_.size();
+  out.resize(k);
+  uint64_t carry = 0;
+  if (a[0] & 1) {
+    carry = add_words(out.data(), a.data(), n_.data(), k);
+  } else {
+    std::copy(a.begin(), a.end(), out.begin());
+  }
+  for (size_t i = 0; i < k; ++i) {
+    uint64_t next = (i + 1 < k ? out[i + 1] : carry);
+    out[i] = (out[i] >> 1) | (next << 63);
+  }
+}
+
+// fixed 4-bit windows: one multiplication per four squarings
+residue montgomery::pow(residue const& base, big_integer const& exp) const {
+  if (exp.is_negative()) {
+    throw std::invalid_argument("Negative exponent");
+  }
+  std::array<residue, 16> table;
+  table[0] = one_;
+  for (size_t i = 1; i < table.size(); ++i) {
+    mul(table[i], table[i - 1], base);
+  }
+  std::vector<uint32_t> limbs = to_limbs(exp);
+  residue res = one_;
+  bool started = false;
+  for (size_t i = limbs.size() * 8; i-- > 0;) {
+    uint32_t window = (limbs[i / 8] >> (i % 8 * 4)) & 15;
+    if (started) {
+      for (int j = 0; j < 4; ++j) {
+        mul(res, res, res);
+      }
+    }
+    if (window != 0) {
+      mul(res, res, table[window]);
+      started = true;
+    }
+  }
+  return res;
+}
+
+big_integer pow_mod(big_integer const& base, big_integer const& exp,
+                    big_integer const& mod) {
+  if (mod.is_negative() || mod.is_zero()) {
+    throw std::invalid_argument("Modulus must be positive");
+  }
+  if (exp.is_negative()) {
+    throw std::invalid_argument("Negative exponent");
+  }
+  if (mod.bit_length() == 1) {
+    return 0;
+  }
+  if (to_limbs(mod)[0] % 2 != 0) {
+    montgomery m(mod);
+    return m.from_residue(m.pow(m.to_residue(base), exp));
+  }
+  big_integer b = base % mod;
+  if (b.is_negative()) {
+    b += mod;
+  }
+  big_integer res = 1;
+  std::vector<uint32_t> limbs = to_limbs(exp);
+  for (size_t i = limbs.size() * 32; i-- > 0;) {
+    res = res * res % mod;
+    if ((limbs[i / 32] >> (i % 32)) & 1) {
+      res = res * b % mod;
+    }
+  }
+  return res;
+}
+
+namespace {
+constexpr uint32_t SIEVE_LIMIT = 2048;
+
+constexpr std::array<bool, SIEVE_LIMIT> sieve() {
+  std::array<bool, SIEVE_LIMIT> composite {};
+  for (uint32_t i = 2; i * i < SIEVE_LIMIT; ++i) {
+    if (!composite[i]) {
+      for (uint32_t j = i * i; j < SIEVE_LIMIT; j += i) {
+        composite[j] = true;
+      }
+    }
+  }
+  return composite;
+}
+
+constexpr std::array<bool, SIEVE_LIMIT> COMPOSITE = sieve();
+
+constexpr size_t ODD_PRIMES = [] {
+  size_t count = 0;
+  for (uint32_t i = 3; i < SIEVE_LIMIT; i += 2) {
+    count += (COMPOSITE[i] ? 0 : 1);
+  }
+  return count;
+}();
+
+constexpr std::array<uint32_t, ODD_PRIMES> PRIMES = [] {
+  std::array<uint32_t, ODD_PRIMES> res {};
+  size_t count = 0;
+  for (uint32_t i = 3; i < SIEVE_LIMIT; i += 2) {
+    if (!COMPOSITE[i]) {
+      res[count++] = i;
+    }
+  }
+  return res;
+}();
+
+// consecutive primes multiplied while the product fits in 32 bits, so a
+// pass over the limbs costs one division per group instead of per prime
+struct prime_group {
+  uint32_t product;
+  size_t first;
+  size_t last;
+};
+
+template <typename F>
+constexpr void for_each_group(F f) {
+  size_t first = 0;
+  while (first < ODD_PRIMES) {
+    uint64_t product = 1;
+    size_t last = first;
+    while (last < ODD_PRIMES && product * PRIMES[last] <= UINT32_MAX) {
+      product *= PRIMES[last++];
+    }
+    f(prime_group {static_cast<uint32_t>(product), first, last});
+    first = last;
+  }
+}
+
+constexpr size_t GROUPS = [] {
+  size_t count = 0;
+  for_each_group([&](prime_group) { ++count; });
+  return count;
+}();
+
+constexpr std::array<prime_group, GROUPS> PRIME_GROUPS = [] {
+  std::array<prime_group, GROUPS> res {};
+  size_t count = 0;
+  for_each_group([&](prime_group g) { res[count++] = g; });
+  return res;
+}();
+
+// remainders modulo every small odd prime, all groups advance together in
+// a single pass over the limbs
+std::array<uint32_t, ODD_PRIMES> small_remainders(
+    std::vector<uint32_t> const& limbs) {
+  std::array<uint64_t, GROUPS> acc {};
+  for (size_t i = limbs.size(); i-- > 0;) {
+    for (size_t g = 0; g < GROUPS; ++g) {
+      acc[g] = ((acc[g] << 32) | limbs[i]) % PRIME_GROUPS[g].product;
+    }
+  }
+  std::array<uint32_t, ODD_PRIMES> res {};
+  for (size_t g = 0; g < GROUPS; ++g) {
+    for (size_t p = PRIME_GROUPS[g].first; p < PRIME_GROUPS[g].last; ++p) {
+      res[p] = static_cast<uint32_t>(acc[g] % PRIMES[p]);
+    }
+  }
+  return res;
+}
+
+uint32_t remainder(std::vector<uint32_t> const& limbs, uint32_t m) {
+  uint64_t r = 0;
+  for (size_t i = limbs.size(); i-- > 0;) {
+    r = ((r << 32) | limbs[i]) % m;
+  }
+  return static_cast<uint32_t>(r);
+}
+
+// Jacobi symbol (a / n) for odd n > 0
+int jacobi(uint64_t a, uint64_t n) {
+  int res = 1;
+  a %= n;
+  while (a != 0) {
+    while (a % 2 == 0) {
+      a /= 2;
+      if (n % 8 == 3 || n % 8 == 5) {
+        res = -res;
+      }
+    }
+    std::swap(a, n);
+    if (a % 4 == 3 && n % 4 == 3) {
+      res = -res;
+    }
+    a %= n;
+  }
+  return (n == 1 ? res : 0);
+}
+
+int jacobi(int64_t a, std::vector<uint32_t> const& n) {
+  int res = 1;
+  uint64_t n8 = n[0] % 8;
+  if (a < 0) {
+    a = -a;
+    res = (n8 % 4 == 1 ? res : -res);
+  }
+  while (a % 2 == 0) {
+    a /= 2;
+    res = (n8 == 1 || n8 == 7 ? res : -res);
+  }
+  if (a == 1) {
+    return res;
+  }
+  // reciprocity reduces to machine words
+  if (a % 4 == 3 && n8 % 4 == 3) {
+    res = -res;
+  }
+  return res * jacobi(remainder(n, static_cast<uint32_t>(a)),
+                      static_cast<uint64_t>(a));
+}
+
+size_t trailing_zeros(std::vector<uint32_t> const& limbs) {
+  size_t i = 0;
+  while (limbs[i] == 0) {
+    ++i;
+  }
+  size_t bits = i * 32;
+  for (uint32_t w = limbs[i]; (w & 1) == 0; w >>= 1) {
+    ++bits;
+  }
+  return bits;
+}
+
+bool test_bit(std::vector<uint32_t> const& limbs, size_t i) {
+  return (limbs[i / 32] >> (i % 32)) & 1;
+}
+
+// a^d = 1 or a^(d 2^r) = -1 for some r < s, where n - 1 = d 2^s
+bool strong_probable_prime(montgomery const& m, residue const& base,
+                           big_integer const& d, size_t s,
+                           residue const& minus_one) {
+  residue x = m.pow(base, d);
+  if (x == m.one() || x == minus_one) {
+    return true;
+  }
+  for (size_t r = 1; r < s; ++r) {
+    m.mul(x, x, x);
+    if (x == minus_one) {
+      return true;
+    }
+    if (x == m.one()) {
+      return false;
+    }
+  }
+  return false;
+}
+
+// strong Lucas test with Selfridge's parameters P = 1, Q = (1 - D) / 4
+bool strong_lucas_probable_prime(montgomery const& m, big_integer const& n,
+                                 std::vector<uint32_t> const& limbs) {
+  int64_t d = 5;
+  for (int tries = 0;; ++tries) {
+    int j = jacobi(d, limbs);
+    if (j == 0) {
+      return false;
+    }
+    if (j == -1) {
+      break;
+    }
+    // no D exists for squares
+    if (tries == 10) {
+      big_integer root = isqrt(n);
+      if (root * root == n) {
+        return false;
+      }
+    }
+    d = (d > 0 ? -d - 2 : -d + 2);
+  }
+  residue dm = m.to_residue(d);
+  residue qm = m.to_residue((1 - d) / 4);
+  std::vector<uint32_t> k = to_limbs(n + 1);
+  size_t s = trailing_zeros(k);
+  size_t k_bits = (n + 1).bit_length();
+  residue u(m.size());
+  residue v = m.one();
+  m.add(v, v, v);
+  residue qk = m.one();
+  residue t(m.size());
+  for (size_t i = k_bits; i-- > s;) {
+    // doubling: U2k = Uk Vk, V2k = Vk^2 - 2 Q^k
+    m.mul(u, u, v);
+    m.mul(v, v, v);
+    m.sub(v, v, qk);
+    m.sub(v, v, qk);
+    m.mul(qk, qk, qk);
+    if (test_bit(k, i)) {
+      // Uk+1 = (Uk + Vk) / 2, Vk+1 = (D Uk + Vk) / 2
+      m.mul(t, dm, u);
+      m.add(u, u, v);
+      m.half(u, u);
+      m.add(v, t, v);
+      m.half(v, v);
+      m.mul(qk, qk, qm);
+    }
+  }
+  if (is_zero_words(u)) {
+    return true;
+  }
+  for (size_t r = 0; r < s; ++r) {
+    if (is_zero_words(v)) {
+      return true;
+    }
+    m.mul(v, v, v);
+    m.sub(v, v, qk);
+    m.sub(v, v, qk);
+    m.mul(qk, qk, qk);
+  }
+  return false;
+}
+
+// n is odd, greater than SIEVE_LIMIT^2 and has no small factors
+bool baillie_psw(big_integer const& n, std::vector<uint32_t> const& limbs,
+                 size_t rounds) {
+  montgomery m(n);
+  residue minus_one(m.size());
+  m.sub(minus_one, minus_one, m.one());
+  std::vector<uint32_t> n1 = to_limbs(n - 1);
+  size_t s = trailing_zeros(n1);
+  big_integer d = (n - 1) >> static_cast<int>(s);
+  if (!strong_probable_prime(m, m.to_residue(2), d, s, minus_one) ||
+      !strong_lucas_probable_prime(m, n, limbs)) {
+    return false;
+  }
+  std::mt19937_64 rng(n.hash());
+  big_integer range = n - 3;
+  for (size_t i = 0; i < rounds; ++i) {
+    std::vector<uint32_t> random(limbs.size() + 1);
+    for (uint32_t& w : random) {
+      w = static_cast<uint32_t>(rng());
+    }
+    big_integer base = from_limbs(random.data(), random.size()) % range + 2;
+    if (!strong_probable_prime(m, m.to_residue(base), d, s, minus_one)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool is_small(std::vector<uint32_t> const& limbs, uint64_t bound) {
+  return limbs.size() <= 1 && (limbs.empty() || limbs[0] < bound);
+}
+} // namespace
+
+bool is_probable_prime(big_integer const& n, size_t rounds) {
+  if (n.is_negative()) {
+    return false;
+  }
+  std::vector<uint32_t> limbs = to_limbs(n);
+  if (is_small(limbs, SIEVE_LIMIT)) {
+    return !limbs.empty() && limbs[0] >= 2 && !COMPOSITE[limbs[0]];
+  }
+  if (limbs[0] % 2 == 0) {
+    return false;
+  }
+  std::array<uint32_t, ODD_PRIMES> r = small_remainders(limbs);
+  if (std::find(r.begin(), r.end(), 0u) != r.end()) {
+    return false;
+  }
+  if (is_small(limbs, SIEVE_LIMIT * SIEVE_LIMIT)) {
+    return true;
+  }
+  return baillie_psw(n, limbs, rounds);
+}
+
+big_integer next_prime(big_integer const& n) {
+  if (n.is_negative() || n.bit_length() < 2) {
+    return 2;
+  }
+  big_integer base = n + 1;
+  std::vector<uint32_t> limbs = to_limbs(base);
+  if (limbs[0] % 2 == 0) {
+    ++base;
+    limbs = to_limbs(base);
+  }
+  if (is_small(limbs, SIEVE_LIMIT * SIEVE_LIMIT)) {
+    while (!is_probable_prime(base)) {
+      base += 2;
+    }
+    return base;
+  }
+  // candidates base + offset are sieved by updating the remainders, only
+  // the survivors are converted and tested
+  std::array<uint32_t, ODD_PRIMES> r = small_remainders(limbs);
+  for (uint64_t offset = 0;; offset += 2) {
+    bool divisible = false;
+    for (size_t i = 0; i < ODD_PRIMES; ++i) {
+      divisible |= (r[i] == 0);
+      r[i] += 2;
+      r[i] = (r[i] >= PRIMES[i] ? r[i] - PRIMES[i] : r[i]);
+    }
+    if (!divisible) {
+      big_integer candidate = base + offset;
+      if (baillie_psw(candidate, to_limbs(candidate), 0)) {
+        return candidate;
+      }
+    }
+  }
+}
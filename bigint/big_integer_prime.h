@@ -0,0 +1,47 @@
+#pragma once
+
+#include "big_integer.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Arithmetic modulo an odd n > 1 on residues in Montgomery form
+// x * 2^(64k) mod n, where k is the number of 64-bit words of n. Residues
+// are vectors of exactly k words; out parameters may alias the inputs.
+struct montgomery {
+  using residue = std::vector<uint64_t>;
+
+  explicit montgomery(big_integer const& modulus);
+
+  residue to_residue(big_integer const& a) const;
+  big_integer from_residue(residue const& a) const;
+  residue const& one() const;
+
+  void mul(residue& out, residue const& a, residue const& b) const;
+  void add(residue& out, residue const& a, residue const& b) const;
+  void sub(residue& out, residue const& a, residue const& b) const;
+  // out = a / 2
+  void half(residue& out, residue const& a) const;
+  residue pow(residue const& base, big_integer const& exp) const;
+
+  size_t size() const;
+
+private:
+  residue n_;
+  // -n^(-1) mod 2^64
+  uint64_t inv_;
+  // 2^(64k) and 2^(128k) mod n
+  residue one_;
+  residue r2_;
+  big_integer modulus_;
+};
+
+big_integer pow_mod(big_integer const& base, big_integer const& exp,
+                    big_integer const& mod);
+
+// Baillie-PSW: trial division by small primes, a strong Fermat test to
+// base 2 and a strong Lucas test. No composite passing it is known.
+// `rounds` adds Miller-Rabin tests to pseudo-random bases.
+bool is_probable_prime(big_integer const& n, size_t rounds = 0);
+// smallest probable prime greater than n
+big_integer next_prime(big_integer const& n);
@@ -0,0 +1,95 @@
+#include "big_integer_stats.h"
+#include <atomic>
+#include <bit>
+
+namespace bigint_stats {
+namespace {
+struct counters {
+  std::atomic<uint64_t> calls[OPERATIONS] {};
+  std::atomic<uint64_t> limbs[OPERATIONS][BUCKETS] {};
+  std::atomic<uint64_t> nanoseconds[TIMERS] {};
+  std::atomic<uint64_t> allocations {0};
+  std::atomic<uint64_t> allocated_bytes {0};
+};
+
+counters& global() {
+  static counters c;
+  return c;
+}
+
+size_t bucket(size_t limbs) {
+  size_t b = std::bit_width(limbs);
+  return (b < BUCKETS ? b : BUCKETS - 1);
+}
+} // namespace
+
+char const* name(operation op) {
+  constexpr char const* NAMES[OPERATIONS] = {
+      "add",     "sub",   "mul",     "div",       "mod",
+      "bitwise", "shift", "compare", "to_string", "from_string"};
+  return NAMES[static_cast<size_t>(op)];
+}
+
+char const* name(timer t) {
+  constexpr char const* NAMES[TIMERS] = {"multiply", "divide", "to_string",
+                                         "from_string"};
+  return NAMES[static_cast<size_t>(t)];
+}
+
+snapshot take() {
+  snapshot res;
+  if constexpr (enabled) {
+    counters& c = global();
+    for (size_t i = 0; i < OPERATIONS; ++i) {
+      res.calls[i] = c.calls[i].load(std::memory_order_relaxed);
+      for (size_t j = 0; j < BUCKETS; ++j) {
+        res.limbs[i][j] = c.limbs[i][j].load(std::memory_order_relaxed);
+      }
+    }
+    for (size_t i = 0; i < TIMERS; ++i) {
+      res.nanoseconds[i] = c.nanoseconds[i].load(std::memory_order_relaxed);
+    }
+    res.allocations = c.allocations.load(std::memory_order_relaxed);
+    res.allocated_bytes = c.allocated_bytes.load(std::memory_order_relaxed);
+  }
+  return res;
+}
+
+void reset() {
+  if constexpr (enabled) {
+    counters& c = global();
+    for (size_t i = 0; i < OPERATIONS; ++i) {
+      c.calls[i].store(0, std::memory_order_relaxed);
+      for (size_t j = 0; j < BUCKETS; ++j) {
+        c.limbs[i][j].store(0, std::memory_order_relaxed);
+      }
+    }
+    for (size_t i = 0; i < TIMERS; ++i) {
+      c.nanoseconds[i].store(0, std::memory_order_relaxed);
+    }
+    c.allocations.store(0, std::memory_order_relaxed);
+    c.allocated_bytes.store(0, std::memory_order_relaxed);
+  }
+}
+
+namespace detail {
+void record(operation op, size_t limbs) {
+  counters& c = global();
+  auto i = static_cast<size_t>(op);
+  c.calls[i].fetch_add(1, std::memory_order_relaxed);
+  c.limbs[i][bucket(limbs)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void record_time(timer t, std::chrono::steady_clock::duration elapsed) {
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+  global().nanoseconds[static_cast<size_t>(t)].fetch_add(
+      ns.count(), std::memory_order_relaxed);
+}
+
+void record_allocation(size_t bytes) {
+  counters& c = global();
+  c.allocations.fetch_add(1, std::memory_order_relaxed);
+  c.allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+} // namespace detail
+} // namespace bigint_stats
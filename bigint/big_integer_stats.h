@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Operation statistics for big_integer, compiled in with -DBIGINT_STATS.
+// Every translation unit that includes big_integer.h has to agree on the
+// flag, since it changes the limb storage type. Without it the hooks expand
+// to nothing and take() returns zeros. Link big_integer_stats.cpp.
+//
+//   bigint_stats::snapshot s = bigint_stats::take();
+//   s.calls[size_t(bigint_stats::operation::mul)];
+namespace bigint_stats {
+
+#ifdef BIGINT_STATS
+constexpr bool enabled = true;
+#else
+constexpr bool enabled = false;
+#endif
+
+enum class operation : size_t {
+  add,
+  sub,
+  mul,
+  div,
+  mod,
+  bitwise,
+  shift,
+  compare,
+  to_string,
+  from_string,
+  count
+};
+
+enum class timer : size_t { multiply, divide, to_string, from_string, count };
+
+constexpr size_t OPERATIONS = static_cast<size_t>(operation::count);
+constexpr size_t TIMERS = static_cast<size_t>(timer::count);
+// bucket 0 holds zero limbs, bucket k holds [2^(k-1), 2^k), the last one
+// everything above
+constexpr size_t BUCKETS = 24;
+
+char const* name(operation op);
+char const* name(timer t);
+
+struct snapshot {
+  std::array<uint64_t, OPERATIONS> calls {};
+  // limb count of the larger operand
+  std::array<std::array<uint64_t, BUCKETS>, OPERATIONS> limbs {};
+  std::array<uint64_t, TIMERS> nanoseconds {};
+  uint64_t allocations = 0;
+  uint64_t allocated_bytes = 0;
+};
+
+// counters are relaxed atomics, so a snapshot taken while other threads
+// are running is not a single consistent point in time
+snapshot take();
+void reset();
+
+namespace detail {
+void record(operation op, size_t limbs);
+void record_time(timer t, std::chrono::steady_clock::duration elapsed);
+void record_allocation(size_t bytes);
+
+struct scoped_timer {
+  explicit scoped_timer(timer t)
+      : t(t), start(std::chrono::steady_clock::now()) {}
+  scoped_timer(scoped_timer const&) = delete;
+  scoped_timer& operator=(scoped_timer const&) = delete;
+  ~scoped_timer() {
+    record_time(t, std::chrono::steady_clock::now() - start);
+  }
+
+  timer t;
+  std::chrono::steady_clock::time_point start;
+};
+
+template <typename T, typename Base = std::allocator<T>>
+struct counting_allocator : Base {
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = counting_allocator<
+        U, typename std::allocator_traits<Base>::template rebind_alloc<U>>;
+  };
+
+  counting_allocator() = default;
+  template <typename U, typename B>
+  counting_allocator(counting_allocator<U, B> const&) noexcept {}
+
+  T* allocate(size_t n) {
+    record_allocation(n * sizeof(T));
+    return Base::allocate(n);
+  }
+};
+} // namespace detail
+} // namespace bigint_stats
+
+#ifdef BIGINT_STATS
+#define BIGINT_STATS_CONCAT_(a, b) a##b
+#define BIGINT_STATS_CONCAT(a, b) BIGINT_STATS_CONCAT_(a, b)
+#define BIGINT_RECORD(op, limbs)                                               \
+  ::bigint_stats::detail::record(::bigint_stats::operation::op, (limbs))
+#define BIGINT_TIME(t)                                                         \
+  ::bigint_stats::detail::scoped_timer BIGINT_STATS_CONCAT(bigint_timer_,     \
+                                                           __LINE__)(          \
+      ::bigint_stats::timer::t)
+#else
+#define BIGINT_RECORD(op, limbs) ((void)0)
+#define BIGINT_TIME(t) ((void)0)
+#endif
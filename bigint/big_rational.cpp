@@ -0,0 +1,262 @@
+#include "big_rational.h"
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+bool is_one(big_integer const& a) {
+  return !a.is_negative() && a.bit_length() == 1;
+}
+
+void add_to(big_integer& a, big_integer const& b, bool subtract) {
+  if (subtract) {
+    a -= b;
+  } else {
+    a += b;
+  }
+}
+
+int sign(big_integer const& a) {
+  return (a.is_negative() ? -1 : (a.is_zero() ? 0 : 1));
+}
+} // namespace
+
+big_rational::big_rational(int a) : num_(a) {}
+
+big_rational::big_rational(big_integer num) : num_(std::move(num)) {}
+
+big_rational::big_rational(big_integer num, big_integer den)
+    : num_(std::move(num)), den_(std::move(den)) {
+  if (den_.is_zero()) {
+    throw std::invalid_argument("Zero denominator");
+  }
+  if (den_.is_negative()) {
+    num_.negate();
+    den_.negate();
+  }
+  reduced_ = is_one(den_);
+}
+
+big_rational::big_rational(std::string const& str) {
+  size_t slash = str.find('/');
+  if (slash == std::string::npos) {
+    num_ = big_integer(str);
+  } else {
+    *this = big_rational(big_integer(str.substr(0, slash)),
+                         big_integer(str.substr(slash + 1)));
+  }
+}
+
+big_rational& big_rational::add(big_rational const& rhs, bool subtract) {
+  if (&rhs == this) {
+    big_rational copy = rhs;
+    return add(copy, subtract);
+  }
+  // gcd(a + c * b, b) = gcd(a, b), so adding an integer keeps the
+  // fraction reduced
+  if (den_ == rhs.den_) {
+    add_to(num_, rhs.num_, subtract);
+    reduced_ = is_one(den_);
+  } else if (is_one(rhs.den_)) {
+    big_integer t = rhs.num_ * den_;
+    add_to(num_, t, subtract);
+  } else if (is_one(den_)) {
+    num_ *= rhs.den_;
+    add_to(num_, rhs.num_, subtract);
+    den_ = rhs.den_;
+    reduced_ = rhs.reduced_;
+  } else {
+    num_ *= rhs.den_;
+    big_integer t = rhs.num_ * den_;
+    add_to(num_, t, subtract);
+    den_ *= rhs.den_;
+    reduced_ = false;
+  }
+  return *this;
+}
+
+big_rational& big_rational::operator+=(big_rational const& rhs) {
+  return add(rhs, false);
+}
+
+big_rational& big_rational::operator-=(big_rational const& rhs) {
+  return add(rhs, true);
+}
+
+big_rational& big_rational::multiply(big_integer const& num,
+                                     big_integer const& den, bool reduced) {
+  // (a / b) * (c / d) = ((a / g1) * (c / g2)) / ((b / g2) * (d / g1)),
+  // which is in lowest terms when both factors are
+  big_integer g1 = gcd(num_, den);
+  big_integer g2 = gcd(num, den_);
+  if (!is_one(g1)) {
+    num_ /= g1;
+  }
+  if (!is_one(g2)) {
+    den_ /= g2;
+  }
+  if (is_one(g2)) {
+    num_ *= num;
+  } else {
+    num_ *= num / g2;
+  }
+  if (is_one(g1)) {
+    den_ *= den;
+  } else {
+    den_ *= den / g1;
+  }
+  reduced_ = reduced_ && reduced;
+  return *this;
+}
+
+big_rational& big_rational::operator*=(big_rational const& rhs) {
+  if (&rhs == this) {
+    num_ *= num_;
+    den_ *= den_;
+    return *this;
+  }
+  return multiply(rhs.num_, rhs.den_, rhs.reduced_);
+}
+
+big_rational& big_rational::operator/=(big_rational const& rhs) {
+  if (rhs.num_.is_zero()) {
+    throw std::invalid_argument("Division by zero");
+  }
+  big_integer num = rhs.den_;
+  big_integer den = rhs.num_;
+  if (den.is_negative()) {
+    num.negate();
+    den.negate();
+  }
+  return multiply(num, den, rhs.reduced_);
+}
+
+big_rational big_rational::operator+() const {
+  return *this;
+}
+
+big_rational big_rational::operator-() const {
+  big_rational res = *this;
+  res.num_ = -res.num_;
+  return res;
+}
+
+int big_rational::compare(big_rational const& a, big_rational const& b) {
+  int sa = sign(a.num_);
+  int sb = sign(b.num_);
+  if (sa != sb || sa == 0) {
+    return (sa < sb ? -1 : (sa > sb ? 1 : 0));
+  }
+  if (a.den_ == b.den_) {
+    return (a.num_ < b.num_ ? -1 : (a.num_ == b.num_ ? 0 : 1));
+  }
+  // |x * y| has bit_length(x) + bit_length(y) or one bit less
+  size_t la = a.num_.bit_length() + b.den_.bit_length();
+  size_t lb = b.num_.bit_length() + a.den_.bit_length();
+  if (la + 2 <= lb) {
+    return -sa;
+  }
+  if (lb + 2 <= la) {
+    return sa;
+  }
+  big_integer x = a.num_ * b.den_;
+  big_integer y = b.num_ * a.den_;
+  return (x < y ? -1 : (x == y ? 0 : 1));
+}
+
+bool operator==(big_rational const& a, big_rational const& b) {
+  if (a.reduced_ && b.reduced_) {
+    return a.num_ == b.num_ && a.den_ == b.den_;
+  }
+  return big_rational::compare(a, b) == 0;
+}
+
+bool operator!=(big_rational const& a, big_rational const& b) {
+  return !(a == b);
+}
+
+bool operator<(big_rational const& a, big_rational const& b) {
+  return big_rational::compare(a, b) < 0;
+}
+
+bool operator>(big_rational const& a, big_rational const& b) {
+  return big_rational::compare(a, b) > 0;
+}
+
+bool operator<=(big_rational const& a, big_rational const& b) {
+  return big_rational::compare(a, b) <= 0;
+}
+
+bool operator>=(big_rational const& a, big_rational const& b) {
+  return big_rational::compare(a, b) >= 0;
+}
+
+big_rational operator+(big_rational a, big_rational const& b) {
+  return a += b;
+}
+
+big_rational operator-(big_rational a, big_rational const& b) {
+  return a -= b;
+}
+
+big_rational operator*(big_rational a, big_rational const& b) {
+  return a *= b;
+}
+
+big_rational operator/(big_rational a, big_rational const& b) {
+  return a /= b;
+}
+
+void big_rational::reduce() {
+  if (reduced_) {
+    return;
+  }
+  big_integer g = gcd(num_, den_);
+  if (!is_one(g)) {
+    num_ /= g;
+    den_ /= g;
+  }
+  reduced_ = true;
+}
+
+big_rational big_rational::reduced() const {
+  big_rational res = *this;
+  res.reduce();
+  return res;
+}
+
+bool big_rational::is_reduced() const {
+  return reduced_;
+}
+
+big_integer const& big_rational::numerator() {
+  reduce();
+  return num_;
+}
+
+big_integer const& big_rational::denominator() {
+  reduce();
+  return den_;
+}
+
+big_integer big_rational::numerator() const {
+  return (reduced_ ? num_ : reduced().num_);
+}
+
+big_integer big_rational::denominator() const {
+  return (reduced_ ? den_ : reduced().den_);
+}
+
+std::string to_string(big_rational const& a) {
+  if (!a.reduced_) {
+    return to_string(a.reduced());
+  }
+  if (is_one(a.den_)) {
+    return to_string(a.num_);
+  }
+  return to_string(a.num_) + "/" + to_string(a.den_);
+}
+
+std::ostream& operator<<(std::ostream& s, big_rational const& a) {
+  return s << to_string(a);
+}
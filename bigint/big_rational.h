@@ -0,0 +1,68 @@
+#pragma once
+
+#include "big_integer.h"
+#include <iosfwd>
+#include <string>
+
+// Exact rational number. The denominator is always positive, but the
+// fraction is reduced only when it is observed or explicitly by reduce().
+// Observing a non-const number reduces it in place; const access computes
+// the lowest terms without modifying the number, so a const big_rational
+// can be read from several threads. Sums keep a common denominator
+// without a gcd, products cancel across the operands instead of reducing
+// the full result, and comparisons try bit lengths before multiplying.
+struct big_rational {
+  big_rational() = default;
+  big_rational(int a);
+  big_rational(big_integer num);
+  big_rational(big_integer num, big_integer den);
+  explicit big_rational(std::string const& str);
+
+  big_rational& operator+=(big_rational const& rhs);
+  big_rational& operator-=(big_rational const& rhs);
+  big_rational& operator*=(big_rational const& rhs);
+  big_rational& operator/=(big_rational const& rhs);
+
+  big_rational operator+() const;
+  big_rational operator-() const;
+
+  friend bool operator==(big_rational const& a, big_rational const& b);
+  friend bool operator!=(big_rational const& a, big_rational const& b);
+  friend bool operator<(big_rational const& a, big_rational const& b);
+  friend bool operator>(big_rational const& a, big_rational const& b);
+  friend bool operator<=(big_rational const& a, big_rational const& b);
+  friend bool operator>=(big_rational const& a, big_rational const& b);
+
+  friend std::string to_string(big_rational const& a);
+
+  // in lowest terms, reduce first
+  big_integer const& numerator();
+  big_integer const& denominator();
+  // in lowest terms, computed on every call while the number is unreduced
+  big_integer numerator() const;
+  big_integer denominator() const;
+  // brings the fraction to lowest terms
+  void reduce();
+  bool is_reduced() const;
+
+private:
+  big_integer num_;
+  big_integer den_ {1};
+  bool reduced_ = true;
+
+  big_rational& add(big_rational const& rhs, bool subtract);
+  big_rational& multiply(big_integer const& num, big_integer const& den,
+                         bool reduced);
+  // a copy in lowest terms
+  big_rational reduced() const;
+  // sign of a - b
+  static int compare(big_rational const& a, big_rational const& b);
+};
+
+big_rational operator+(big_rational a, big_rational const& b);
+big_rational operator-(big_rational a, big_rational const& b);
+big_rational operator*(big_rational a, big_rational const& b);
+big_rational operator/(big_rational a, big_rational const& b);
+
+std::string to_string(big_rational const& a);
+std::ostream& operator<<(std::ostream& s, big_rational const& a);
@@ -0,0 +1,386 @@
+// Differential fuzzer: runs the same operation sequences on big_integer and
+// on GMP's mpz_class and compares every result.
+//
+// libFuzzer:
+//   clang++ -std=c++20 -O1 -g -fsanitize=fuzzer,address -DBIGINT_LIBFUZZER
+//     fuzz.cpp big_integer.cpp big_integer_ntt.cpp big_integer_mmap.cpp
+//     -lgmpxx -lgmp
+// Standalone (random inputs, or the given files as inputs):
+//   g++ -std=c++20 -O2 fuzz.cpp big_integer.cpp big_integer_ntt.cpp
+//     big_integer_mmap.cpp -lgmpxx -lgmp
+//   ./a.out [--iterations N] [--seed S] [files...]
+// Performance comparison, prints big_integer / GMP time ratios:
+//   ./a.out --bench
+
+#include <gmpxx.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "big_integer.h"
+#include "big_integer_ntt.h"
+
+namespace {
+constexpr size_t REGISTERS = 4;
+// room for wide loads, keeps quadratic operations fast enough for fuzzing
+constexpr size_t MAX_BYTES = 16 * bigint_ntt::THRESHOLD;
+
+struct machine {
+  big_integer a[REGISTERS];
+  mpz_class b[REGISTERS];
+};
+
+[[noreturn]] void mismatch(char const* op, machine const& m, size_t reg,
+                           std::string const& expected) {
+  std::fprintf(stderr, "mismatch after %s in r%zu\n  big_integer: %s\n  gmp:         %s\n",
+               op, reg, to_string(m.a[reg], 16).c_str(), expected.c_str());
+  std::abort();
+}
+
+// compares in hexadecimal, which converts in linear time even for wide
+// operands; the other bases are checked by the to_string operation
+void check(char const* op, machine const& m, size_t reg) {
+  std::string expected = m.b[reg].get_str(16);
+  if (to_string(m.a[reg], 16) != expected) {
+    mismatch(op, m, reg, expected);
+  }
+  big_integer parsed = from_string(expected, 16);
+  if (m.a[reg] != parsed || m.a[reg].hash() != parsed.hash()) {
+    mismatch(op, m, reg, expected + " (representation is not canonical)");
+  }
+}
+
+struct reader {
+  uint8_t next() {
+    return (pos < size ? data[pos++] : 0);
+  }
+
+  bool done() const {
+    return pos >= size;
+  }
+
+  uint8_t const* data;
+  size_t size;
+  size_t pos = 0;
+};
+
+void load(machine& m, size_t dst, reader& in) {
+  size_t bytes = in.next() % 64;
+  bool negative = in.next() & 1;
+  std::string hex = "0";
+  for (size_t i = 0; i < bytes; ++i) {
+    uint8_t byte = in.next();
+    // runs of zero and all-one limbs stress carries and normalization
+    if (byte == 0xfe) {
+      hex.append(8, 'f');
+    } else if (byte == 0xfd) {
+      hex.append(8, '0');
+    } else {
+      hex.push_back("0123456789abcdef"[byte >> 4]);
+      hex.push_back("0123456789abcdef"[byte & 15]);
+    }
+  }
+  m.a[dst] = from_string((negative ? "-" : "") + hex, 16);
+  m.b[dst] = mpz_class((negative ? "-" : "") + hex, 16);
+}
+
+// an operand of at least bigint_ntt::THRESHOLD limbs, so that products of
+// two of them take the transform path: a short pattern of limbs repeated,
+// optionally mixed with a pseudo-random sequence seeded from the input
+void load_wide(machine& m, size_t dst, reader& in) {
+  size_t limbs = bigint_ntt::THRESHOLD + in.next() * 4;
+  bool negative = in.next() & 1;
+  bool mixed = in.next() & 1;
+  uint32_t state = in.next() * 0x01010101u;
+  std::vector<uint32_t> pattern(1 + in.next() % 16);
+  for (uint32_t& limb : pattern) {
+    uint8_t byte = in.next();
+    if (byte == 0xfe) {
+      limb = UINT32_MAX;
+    } else if (byte == 0xfd) {
+      limb = 0;
+    } else {
+      limb = byte * 0x01000193u;
+    }
+  }
+  std::string hex = (negative ? "-1" : "1");
+  char buf[9];
+  for (size_t i = 0; i < limbs; ++i) {
+    uint32_t limb = pattern[i % pattern.size()];
+    if (mixed) {
+      state = state * 1664525u + 1013904223u;
+      limb ^= state;
+    }
+    std::snprintf(buf, sizeof(buf), "%08x", limb);
+    hex += buf;
+  }
+  m.a[dst] = from_string(hex, 16);
+  m.b[dst] = mpz_class(hex, 16);
+}
+
+void step(machine& m, reader& in) {
+  uint8_t op = in.next();
+  size_t dst = in.next() % REGISTERS;
+  size_t x = in.next() % REGISTERS;
+  size_t y = in.next() % REGISTERS;
+  if (mpz_sizeinbase(m.b[x].get_mpz_t(), 256) > MAX_BYTES ||
+      mpz_sizeinbase(m.b[y].get_mpz_t(), 256) > MAX_BYTES) {
+    load(m, x, in);
+    check("load", m, x);
+    return;
+  }
+  char const* name = nullptr;
+  switch (op % 21) {
+  case 0:
+    load(m, dst, in);
+    name = "load";
+    break;
+  case 1:
+    m.a[dst] = m.a[x] + m.a[y];
+    m.b[dst] = m.b[x] + m.b[y];
+    name = "+";
+    break;
+  case 2:
+    m.a[dst] = m.a[x] - m.a[y];
+    m.b[dst] = m.b[x] - m.b[y];
+    name = "-";
+    break;
+  case 3:
+    m.a[dst] = m.a[x] * m.a[y];
+    m.b[dst] = m.b[x] * m.b[y];
+    name = "*";
+    break;
+  case 4:
+    if (m.b[y] == 0) {
+      return;
+    }
+    m.a[dst] = m.a[x] / m.a[y];
+    m.b[dst] = m.b[x] / m.b[y];
+    name = "/";
+    break;
+  case 5:
+    if (m.b[y] == 0) {
+      return;
+    }
+    m.a[dst] = m.a[x] % m.a[y];
+    m.b[dst] = m.b[x] % m.b[y];
+    name = "%";
+    break;
+  case 6:
+    m.a[dst] = m.a[x] & m.a[y];
+    m.b[dst] = m.b[x] & m.b[y];
+    name = "&";
+    break;
+  case 7:
+    m.a[dst] = m.a[x] | m.a[y];
+    m.b[dst] = m.b[x] | m.b[y];
+    name = "|";
+    break;
+  case 8:
+    m.a[dst] = m.a[x] ^ m.a[y];
+    m.b[dst] = m.b[x] ^ m.b[y];
+    name = "^";
+    break;
+  case 9: {
+    int shift = in.next();
+    m.a[dst] = m.a[x] << shift;
+    m.b[dst] = m.b[x] << shift;
+    name = "<<";
+    break;
+  }
+  case 10: {
+    int shift = in.next();
+    m.a[dst] = m.a[x] >> shift;
+    m.b[dst] = m.b[x] >> shift;
+    name = ">>";
+    break;
+  }
+  case 11:
+    m.a[dst] = -m.a[x];
+    m.b[dst] = -m.b[x];
+    name = "unary -";
+    break;
+  case 12:
+    m.a[dst] = ~m.a[x];
+    m.b[dst] = ~m.b[x];
+    name = "~";
+    break;
+  case 13:
+    ++m.a[dst];
+    ++m.b[dst];
+    name = "++";
+    break;
+  case 14:
+    --m.a[dst];
+    --m.b[dst];
+    name = "--";
+    break;
+  case 15:
+    m.a[dst] += m.a[x];
+    m.b[dst] += m.b[x];
+    name = "+=";
+    break;
+  case 16:
+    m.a[dst] -= m.a[x];
+    m.b[dst] -= m.b[x];
+    name = "-=";
+    break;
+  case 17: {
+    int expected = cmp(m.b[x], m.b[y]);
+    bool ok = (m.a[x] < m.a[y]) == (expected < 0) &&
+              (m.a[x] > m.a[y]) == (expected > 0) &&
+              (m.a[x] == m.a[y]) == (expected == 0) &&
+              (m.a[x] <= m.a[y]) == (expected <= 0) &&
+              (m.a[x] >= m.a[y]) == (expected >= 0);
+    if (!ok) {
+      mismatch("comparison", m, x, m.b[x].get_str(16) + " vs " + m.b[y].get_str(16));
+    }
+    return;
+  }
+  case 18: {
+    int base = 2 + in.next() % 35;
+    std::string expected = m.b[x].get_str(base);
+    if (to_string(m.a[x], base) != expected) {
+      mismatch("to_string", m, x, expected + " in base " + std::to_string(base));
+    }
+    m.a[dst] = from_string(expected, base);
+    m.b[dst] = m.b[x];
+    name = "from_string";
+    break;
+  }
+  case 19:
+    load_wide(m, dst, in);
+    name = "load wide";
+    break;
+  default:
+    m.a[dst] *= m.a[dst];
+    m.b[dst] *= m.b[dst];
+    name = "*= self";
+    break;
+  }
+  check(name, m, dst);
+}
+
+void run(uint8_t const* data, size_t size) {
+  machine m;
+  reader in {data, size};
+  while (!in.done()) {
+    step(m, in);
+  }
+}
+
+template <typename F>
+double seconds(F f) {
+  size_t iterations = 1;
+  while (true) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+      f();
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (elapsed.count() > 0.05) {
+      return elapsed.count() / iterations;
+    }
+    iterations *= 2;
+  }
+}
+
+void bench() {
+  std::mt19937 rng(42);
+  size_t sink = 0;
+  std::printf("%-10s %8s %14s %14s %8s\n", "operation", "limbs",
+              "big_integer", "gmp", "ratio");
+  for (size_t limbs = 1; limbs <= 4096; limbs *= 4) {
+    std::string hex_a(limbs * 8, '0');
+    std::string hex_b(limbs * 4, '0');
+    for (char& c : hex_a) {
+      c = "0123456789abcdef"[rng() % 16];
+    }
+    for (char& c : hex_b) {
+      c = "0123456789abcdef"[rng() % 16];
+    }
+    hex_a[0] = hex_b[0] = '1';
+    big_integer a = from_string(hex_a, 16);
+    big_integer b = from_string(hex_b, 16);
+    mpz_class ga(hex_a, 16);
+    mpz_class gb(hex_b, 16);
+    auto row = [&](char const* name, auto ours, auto theirs) {
+      double x = seconds(ours);
+      double y = seconds(theirs);
+      std::printf("%-10s %8zu %12.0fns %12.0fns %8.2f\n", name, limbs, x * 1e9,
+                  y * 1e9, x / y);
+    };
+    row("add", [&] { sink += (a + b).hash(); },
+        [&] { sink += mpz_class(ga + gb).get_ui(); });
+    row("sub", [&] { sink += (b - a).hash(); },
+        [&] { sink += mpz_class(gb - ga).get_ui(); });
+    row("mul", [&] { sink += (a * b).hash(); },
+        [&] { sink += mpz_class(ga * gb).get_ui(); });
+    row("div", [&] { sink += (a / b).hash(); },
+        [&] { sink += mpz_class(ga / gb).get_ui(); });
+    row("mod", [&] { sink += (a % b).hash(); },
+        [&] { sink += mpz_class(ga % gb).get_ui(); });
+    row("to_string", [&] { sink += to_string(a).size(); },
+        [&] { sink += ga.get_str().size(); });
+    std::string dec = ga.get_str();
+    row("parse", [&] { sink += big_integer(dec).hash(); },
+        [&] { sink += mpz_class(dec).get_ui(); });
+  }
+  std::printf("checksum %zu\n", sink);
+}
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(uint8_t const* data, size_t size) {
+  run(data, size);
+  return 0;
+}
+
+#ifndef BIGINT_LIBFUZZER
+int main(int argc, char** argv) {
+  size_t iterations = 100000;
+  unsigned seed = 1;
+  std::vector<char const*> files;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--bench") == 0) {
+      bench();
+      return 0;
+    } else if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      iterations = std::strtoull(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  for (char const* file : files) {
+    std::ifstream in(file, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)),
+                              std::istreambuf_iterator<char>());
+    run(data.data(), data.size());
+  }
+  if (!files.empty()) {
+    return 0;
+  }
+  std::mt19937 rng(seed);
+  std::vector<uint8_t> data;
+  for (size_t it = 0; it < iterations; ++it) {
+    data.resize(rng() % 512);
+    for (uint8_t& byte : data) {
+      byte = static_cast<uint8_t>(rng());
+    }
+    run(data.data(), data.size());
+  }
+  std::printf("%zu random inputs passed\n", iterations);
+  return 0;
+}
+#endif
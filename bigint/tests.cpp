@@ -1,11 +1,24 @@
 #include "gtest/gtest.h"
 #include <algorithm>
 #include <cassert>
+#include <cstdio>
 #include <cstdlib>
 #include <limits>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "big_float.h"
 #include "big_integer.h"
+#include "big_integer_batch.h"
+#include "big_integer_constexpr.h"
+#include "big_integer_expr.h"
+#include "big_integer_mmap.h"
+#include "big_integer_prime.h"
+#include "big_rational.h"
 
 TEST(correctness, two_plus_two) {
   EXPECT_EQ(big_integer(4), big_integer(2) + big_integer(2));
@@ -511,6 +524,118 @@ TEST(correctness, sub_long_pow2) {
   EXPECT_EQ(1, a - b);
 }
 
+TEST(correctness, add_carry_run) {
+  std::vector<uint32_t> ones(100, UINT32_MAX);
+  big_integer a = from_limbs(ones.data(), ones.size());
+  big_integer power = big_integer(1) << 3200;
+
+  a += 1;
+  EXPECT_EQ(power, a);
+  EXPECT_EQ(101u, to_limbs(a).size());
+  a -= 1;
+  EXPECT_EQ(from_limbs(ones.data(), ones.size()), a);
+  EXPECT_EQ(100u, to_limbs(a).size());
+
+  big_integer b = -power;
+  b += 1;
+  EXPECT_EQ(-from_limbs(ones.data(), ones.size()), b);
+  b -= 1;
+  EXPECT_EQ(-power, b);
+}
+
+TEST(correctness, add_borrow_run) {
+  std::vector<uint32_t> limbs(100, 0);
+  limbs.back() = 1;
+  big_integer a = from_limbs(limbs.data(), limbs.size());
+  big_integer b = a - 1;
+  EXPECT_EQ(99u, to_limbs(b).size());
+  EXPECT_EQ(std::vector<uint32_t>(99, UINT32_MAX), to_limbs(b));
+  b -= a;
+  EXPECT_EQ(-1, b);
+  b += a;
+  EXPECT_EQ(a - 1, b);
+  EXPECT_EQ(to_string(a - 1), to_string(b));
+}
+
+TEST(correctness, add_top_limb_sign_flip) {
+  big_integer top = big_integer(1) << 95;
+  big_integer a = top - 1;
+  a += 1;
+  EXPECT_EQ(top, a);
+  EXPECT_FALSE(a.is_negative());
+  a -= 1;
+  EXPECT_EQ(top - 1, a);
+
+  big_integer b = -top;
+  b -= 1;
+  EXPECT_EQ(-(top + 1), b);
+  EXPECT_TRUE(b.is_negative());
+  b += 1;
+  EXPECT_EQ(-top, b);
+
+  big_integer c = top;
+  c -= top + 1;
+  EXPECT_EQ(-1, c);
+  EXPECT_TRUE(c.is_negative());
+  c += 1;
+  EXPECT_TRUE(c.is_zero());
+  EXPECT_EQ(big_integer().hash(), c.hash());
+}
+
+TEST(correctness, add_self) {
+  for (char const* str :
+       {"0", "1", "-1", "2147483648", "-2147483648", "4294967295",
+        "-4294967296", "170141183460469231731687303715884105728",
+        "-340282366920938463463374607431768211455"}) {
+    big_integer x(str);
+    big_integer a = x;
+    a += a;
+    EXPECT_EQ(x * 2, a);
+    EXPECT_EQ(to_string(x * 2), to_string(a));
+    a -= a;
+    EXPECT_TRUE(a.is_zero());
+    EXPECT_EQ(0, a);
+  }
+}
+
+TEST(correctness, add_reserved_capacity) {
+  big_integer a = 1;
+  a.reserve(64);
+  big_integer b = big_integer(1) << 1000;
+  bigint_stats::reset();
+  for (int i = 0; i < 100; ++i) {
+    a += b;
+    a -= b;
+    a -= b;
+    a += b;
+    a += a;
+    a -= 1;
+  }
+  EXPECT_EQ(1, a);
+  EXPECT_EQ(0u, bigint_stats::take().allocations);
+}
+
+TEST(correctness, mul_in_place) {
+  std::vector<uint32_t> ones(40, UINT32_MAX);
+  big_integer x = from_limbs(ones.data(), ones.size());
+  big_integer one = big_integer(1) << 1280;
+  // (2^k - 1)^2 = 2^2k - 2^(k+1) + 1
+  EXPECT_EQ((one << 1280) - (one << 1) + 1, x * x);
+  EXPECT_EQ(-x * (one - 1), -(one << 1280) + (one << 1) - 1);
+
+  big_integer a = 1;
+  a.reserve(1000);
+  bigint_stats::reset();
+  for (int i = 0; i < 20; ++i) {
+    a *= x;
+  }
+  EXPECT_EQ(0u, bigint_stats::take().allocations);
+  for (int i = 0; i < 20; ++i) {
+    a /= x;
+  }
+  EXPECT_EQ(1, a);
+}
+
 TEST(correctness, mul_long) {
   big_integer a("10000000000000000000000000000000000000000000000000000000000000"
                 "000000000000000000000000000000");
@@ -708,3 +833,614 @@ TEST(correctness, converting_ctor4) {
 
   EXPECT_EQ(to_string(bignum), std::to_string(num));
 }
+
+TEST(correctness, expr_sum_chain) {
+  using bigint_expr::ref;
+  big_integer a("100000000000000000000000000000");
+  big_integer b("-99999999999999999999999999999");
+  big_integer c = 42;
+  big_integer r;
+
+  bigint_expr::assign(r, ref(a) + ref(b) - ref(c));
+  EXPECT_EQ(a + b - c, r);
+  bigint_expr::assign(r, ref(c) - ref(a) - ref(a) + ref(b));
+  EXPECT_EQ(c - a - a + b, r);
+}
+
+TEST(correctness, expr_mixed) {
+  using bigint_expr::ref;
+  big_integer a("123456789012345678901234567890");
+  big_integer b("-98765432109876543210");
+  big_integer c("5555555555555555555555");
+  big_integer d = 17;
+  big_integer m("1000000007000000009");
+
+  big_integer r =
+      bigint_expr::evaluate((ref(a) + ref(b)) * (ref(c) - ref(d)) % ref(m));
+  EXPECT_EQ((a + b) * (c - d) % m, r);
+  EXPECT_EQ(a * b / c + d, bigint_expr::evaluate(a * ref(b) / c + d));
+}
+
+TEST(correctness, expr_aliasing) {
+  using bigint_expr::ref;
+  big_integer x("-314159265358979323846264338327950288");
+  big_integer y("271828182845904523536028747135");
+  big_integer expected = x;
+
+  expected = expected * expected + y;
+  bigint_expr::assign(x, ref(x) * ref(x) + ref(y));
+  EXPECT_EQ(expected, x);
+
+  expected = y - expected * (expected + y);
+  bigint_expr::assign(x, ref(y) - ref(x) * (ref(x) + ref(y)));
+  EXPECT_EQ(expected, x);
+
+  expected = (expected % y) - expected;
+  bigint_expr::assign(x, ref(x) % ref(y) - ref(x));
+  EXPECT_EQ(expected, x);
+}
+
+template <typename L, typename R>
+concept expr_addable = requires(L&& l, R&& r) {
+  std::forward<L>(l) + std::forward<R>(r);
+};
+
+// operands are held by reference, temporaries must not compile
+static_assert(expr_addable<bigint_expr::operand, big_integer&>);
+static_assert(!expr_addable<bigint_expr::operand, big_integer>);
+static_assert(!expr_addable<big_integer, bigint_expr::operand>);
+
+TEST(correctness, expr_alias_many_terms) {
+  using bigint_expr::ref;
+  big_integer x("-4294967296");
+  big_integer y("18446744073709551615");
+  big_integer expected = x + x + y - x - y - y + x;
+  bigint_expr::assign(
+      x, ref(x) + ref(x) + ref(y) - ref(x) - ref(y) - ref(y) + ref(x));
+  EXPECT_EQ(expected, x);
+  EXPECT_EQ(to_string(expected), to_string(x));
+}
+
+TEST(correctness, hash) {
+  big_integer a("123456789012345678901234567890123456789");
+  big_integer b = a;
+  big_integer c = a * 2 - a;
+  EXPECT_EQ(std::hash<big_integer>()(a), std::hash<big_integer>()(b));
+  EXPECT_EQ(a.hash(), c.hash());
+  EXPECT_NE(a.hash(), (-a).hash());
+  EXPECT_NE(big_integer(0).hash(), big_integer(-1).hash());
+
+  size_t h = a.hash();
+  a += 1;
+  EXPECT_NE(h, a.hash());
+  a -= 1;
+  EXPECT_EQ(h, a.hash());
+  EXPECT_EQ(b, a);
+}
+
+TEST(correctness, hash_moved_from) {
+  // a moved-from number has some valid value, and its hash has to match it
+  big_integer a("123456789012345678901234567890123456789");
+  size_t h = a.hash();
+  big_integer b(std::move(a));
+  EXPECT_EQ(h, b.hash());
+  big_integer same_a(to_string(a));
+  EXPECT_EQ(same_a, a);
+  EXPECT_EQ(same_a.hash(), a.hash());
+
+  big_integer c("-98765432109876543210987654321");
+  c.hash();
+  big_integer d;
+  d.hash();
+  d = std::move(c);
+  EXPECT_EQ(big_integer("-98765432109876543210987654321"), d);
+  big_integer same_c(to_string(c));
+  EXPECT_EQ(same_c, c);
+  EXPECT_EQ(same_c.hash(), c.hash());
+}
+
+TEST(correctness, hash_map) {
+  std::unordered_map<big_integer, int> map;
+  big_integer x = 1;
+  for (int i = 0; i < 200; ++i) {
+    map[x] = i;
+    x *= 3;
+  }
+  EXPECT_EQ(200, map.size());
+  x = 1;
+  for (int i = 0; i < 200; ++i) {
+    EXPECT_EQ(i, map[x]);
+    x *= 3;
+  }
+}
+
+TEST(correctness, radix_to_string) {
+  big_integer a("-123456789012345678901234567890");
+  EXPECT_EQ("-18ee90ff6c373e0ee4e3f0ad2", to_string(a, 16));
+  EXPECT_EQ("-143564417755415637016711617605322", to_string(a, 8));
+  EXPECT_EQ("-byw97um9s91dlz68tsi", to_string(a, 36));
+  EXPECT_EQ("1111111111111111111111111111111111111111111111111111111111111111",
+            to_string(big_integer(UINT64_MAX), 2));
+  EXPECT_EQ("0", to_string(big_integer(), 7));
+  EXPECT_THROW(to_string(a, 1), std::invalid_argument);
+  EXPECT_THROW(to_string(a, 37), std::invalid_argument);
+}
+
+TEST(correctness, radix_from_string) {
+  big_integer a("-123456789012345678901234567890");
+  EXPECT_EQ(a, from_string("-18EE90FF6C373E0EE4E3F0AD2", 16));
+  EXPECT_EQ(a, from_string("-143564417755415637016711617605322", 8));
+  EXPECT_EQ(a, from_string("-byw97um9s91dlz68tsi", 36));
+  EXPECT_EQ(big_integer(UINT64_MAX), from_string(std::string(64, '1'), 2));
+  EXPECT_EQ(0, from_string("-0000", 3));
+  EXPECT_THROW(from_string("12", 2), std::invalid_argument);
+  EXPECT_THROW(from_string("-", 16), std::invalid_argument);
+  EXPECT_THROW(from_string("g", 16), std::invalid_argument);
+}
+
+TEST(correctness, radix_round_trip_long) {
+  big_integer a = 1;
+  for (int i = 0; i < 300; ++i) {
+    a *= 1000000007;
+    a -= i;
+  }
+  big_integer b = -a;
+  for (int base = 2; base <= 36; ++base) {
+    EXPECT_EQ(a, from_string(to_string(a, base), base));
+    EXPECT_EQ(b, from_string(to_string(b, base), base));
+  }
+  EXPECT_EQ(to_string(a), to_string(a, 10));
+}
+
+TEST(correctness, stream_base_flags) {
+  std::ostringstream out;
+  out << std::hex << big_integer(-255) << " " << std::showbase
+      << std::uppercase << big_integer(255) << " " << std::oct
+      << big_integer(8) << " " << std::dec << big_integer(10);
+  EXPECT_EQ("-ff 0XFF 010 10", out.str());
+}
+
+#ifdef __cpp_lib_format
+TEST(correctness, format) {
+  big_integer a("-123456789012345678901234567890");
+  EXPECT_EQ("-123456789012345678901234567890", std::format("{}", a));
+  EXPECT_EQ("-123456789012345678901234567890", std::format("{:d}", a));
+  EXPECT_EQ("-18ee90ff6c373e0ee4e3f0ad2", std::format("{:x}", a));
+  EXPECT_EQ("-18EE90FF6C373E0EE4E3F0AD2", std::format("{:X}", a));
+  EXPECT_EQ("-143564417755415637016711617605322", std::format("{:o}", a));
+  EXPECT_EQ("-11111111", std::format("{:b}", big_integer(-255)));
+  EXPECT_EQ("[0 -ff]",
+            std::format("[{} {:x}]", big_integer(), big_integer(-255)));
+  EXPECT_THROW((void)std::vformat("{:e}", std::make_format_args(a)),
+               std::format_error);
+}
+#endif
+
+TEST(correctness, stream_input) {
+  std::istringstream in("  -123456789012345678901234567890 42\n+7 ff x");
+  big_integer a, b, c, d, e;
+  in >> a >> b >> c >> std::hex >> d;
+  EXPECT_EQ(big_integer("-123456789012345678901234567890"), a);
+  EXPECT_EQ(42, b);
+  EXPECT_EQ(7, c);
+  EXPECT_EQ(255, d);
+  EXPECT_TRUE(in.good());
+  in >> std::dec >> e;
+  EXPECT_TRUE(in.fail());
+}
+
+TEST(correctness, stream_input_long) {
+  std::string str(100000, '0');
+  for (size_t i = 0; i < str.size(); ++i) {
+    str[i] = static_cast<char>('0' + (i * 7 + i / 13) % 10);
+  }
+  str[0] = '9';
+  std::istringstream in(str);
+  big_integer a;
+  in >> a;
+  EXPECT_TRUE(in.eof());
+  EXPECT_EQ(big_integer(str), a);
+}
+
+TEST(correctness, read_from_fd) {
+  std::FILE* file = std::tmpfile();
+  ASSERT_NE(nullptr, file);
+  std::string str = "-" + std::string(70000, '8') + "1\n";
+  std::fputs(str.c_str(), file);
+  std::fflush(file);
+  std::rewind(file);
+  EXPECT_EQ(big_integer(str.substr(0, str.size() - 1)),
+            read_big_integer(fileno(file)));
+  std::fclose(file);
+}
+
+TEST(correctness, negative_increment) {
+  big_integer a = -1;
+  ++a;
+  EXPECT_EQ(0, a);
+  EXPECT_EQ(big_integer(), a);
+  a = -2;
+  ++a;
+  EXPECT_EQ(-1, a);
+  EXPECT_EQ(big_integer(-1).hash(), a.hash());
+  big_integer b("-4294967296");
+  ++b;
+  EXPECT_EQ(big_integer("-4294967295"), b);
+}
+
+TEST(correctness, negative_compare_lengths) {
+  big_integer a("-340282366920938463463374607431768211456");
+  big_integer b = -3;
+  EXPECT_TRUE(a < b);
+  EXPECT_FALSE(b < a);
+  EXPECT_TRUE(b > a);
+  EXPECT_TRUE(a <= b);
+}
+
+TEST(correctness, shift_exact_negative) {
+  EXPECT_EQ(-2, big_integer(-4) >> 1);
+  EXPECT_EQ(big_integer("-4294967296"), big_integer("-18446744073709551616") >> 32);
+  EXPECT_EQ(-1, big_integer(-1) >> 100);
+  EXPECT_EQ(0, big_integer(0) << 100);
+  EXPECT_EQ(big_integer(), big_integer(0) << 100);
+  EXPECT_EQ(big_integer("-18446744073709551616"), big_integer(-1) << 64);
+}
+
+TEST(correctness, stats_snapshot) {
+  using namespace bigint_stats;
+  reset();
+  big_integer a("123456789012345678901234567890");
+  big_integer b = a * a;
+  b /= a;
+  EXPECT_EQ(a, b);
+  snapshot s = take();
+  auto mul = static_cast<size_t>(operation::mul);
+  if (enabled) {
+    EXPECT_EQ(1u, s.calls[mul]);
+    EXPECT_EQ(1u, s.limbs[mul][3]);
+    EXPECT_EQ(1u, s.calls[static_cast<size_t>(operation::div)]);
+    EXPECT_LE(1u, s.calls[static_cast<size_t>(operation::from_string)]);
+    EXPECT_LT(0u, s.allocations);
+  } else {
+    EXPECT_EQ(0u, s.calls[mul]);
+    EXPECT_EQ(0u, s.allocations);
+  }
+  reset();
+  EXPECT_EQ(0u, take().calls[mul]);
+  EXPECT_STREQ("mul", name(operation::mul));
+}
+
+TEST(correctness, constexpr_arithmetic) {
+  constexpr auto a = pow(fixed_integer<8>(10), 40);
+  constexpr auto b = fixed_integer<8>("10000000000000000000000000000000000000000");
+  static_assert(a == b);
+  static_assert(a - 1 < a);
+  static_assert((a * 7 + 3).size() == 5);
+  constexpr auto f = factorial<decimal_limbs(158)>(100);
+  EXPECT_EQ(big_integer("933262154439441526816992388562667004907159682643816214685929"
+                        "638952175999932299156089414639761565182862536979208272237582"
+                        "51185210916864000000000000000000000000"),
+            f.to_big_integer());
+  fixed_integer<8> c = a;
+  EXPECT_EQ(0u, c.div_small(10));
+  EXPECT_EQ(to_string(a.to_big_integer() / 10), to_string(c.to_big_integer()));
+  EXPECT_THROW(pow(fixed_integer<2>(10), 20), std::overflow_error);
+}
+
+TEST(correctness, from_limbs) {
+  uint32_t limbs[] = {0, 1, 0};
+  EXPECT_EQ(big_integer("4294967296"), from_limbs(limbs, 3));
+  EXPECT_EQ(big_integer("-4294967296"), from_limbs(limbs, 3, true));
+  EXPECT_EQ(big_integer(), from_limbs(limbs, 1, true));
+  EXPECT_EQ(0, from_limbs(nullptr, 0));
+}
+
+TEST(correctness, radix_concurrent) {
+  std::string str(20000, '0');
+  for (size_t i = 0; i < str.size(); ++i) {
+    str[i] = static_cast<char>('0' + (i * 31 + i / 7) % 10);
+  }
+  str[0] = '5';
+  big_integer a(str);
+  std::string hex = to_string(a, 16);
+  std::vector<std::thread> threads;
+  std::atomic<int> failures {0};
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] {
+      int base = (t % 2 == 0 ? 10 : 7);
+      for (int i = 0; i < 3; ++i) {
+        big_integer b = from_string(to_string(a, base), base);
+        if (b != a || (base == 10 && to_string(b) != str)) {
+          ++failures;
+        }
+      }
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(0, failures.load());
+  EXPECT_EQ(a, from_string(hex, 16));
+}
+
+TEST(correctness, bit_length) {
+  EXPECT_EQ(0u, big_integer(0).bit_length());
+  EXPECT_EQ(1u, big_integer(1).bit_length());
+  EXPECT_EQ(1u, big_integer(-1).bit_length());
+  EXPECT_EQ(2u, big_integer(-2).bit_length());
+  EXPECT_EQ(2u, big_integer(-3).bit_length());
+  EXPECT_EQ(33u, big_integer("4294967296").bit_length());
+  EXPECT_EQ(33u, big_integer("-4294967296").bit_length());
+  EXPECT_EQ(32u, big_integer("-4294967295").bit_length());
+}
+
+TEST(correctness, gcd) {
+  EXPECT_EQ(6, gcd(big_integer(-12), big_integer(18)));
+  EXPECT_EQ(5, gcd(big_integer(0), big_integer(-5)));
+  EXPECT_EQ(0, gcd(big_integer(0), big_integer(0)));
+  big_integer p("1000000000000000000000000000057");
+  EXPECT_EQ(p, gcd(p * 91, p * 100));
+  EXPECT_EQ(p * 91, gcd(p * 91, p * 1001));
+}
+
+TEST(correctness, rational_arithmetic) {
+  big_rational a(big_integer(1), big_integer(6));
+  big_rational b(big_integer(-1), big_integer(-3));
+  EXPECT_EQ("1/2", to_string(a + b));
+  EXPECT_EQ("-1/6", to_string(a - b));
+  EXPECT_EQ("1/18", to_string(a * b));
+  EXPECT_EQ("1/2", to_string(a / b));
+  EXPECT_EQ(big_rational(big_integer(3), big_integer(6)), a + b);
+  EXPECT_EQ(big_rational(1), big_rational("7/7"));
+  EXPECT_EQ("-5", to_string(big_rational("10/-2")));
+  EXPECT_THROW(big_rational(big_integer(1), big_integer(0)), std::invalid_argument);
+  EXPECT_THROW(a / big_rational(), std::invalid_argument);
+  a *= a;
+  EXPECT_EQ("1/36", to_string(a));
+}
+
+TEST(correctness, rational_lazy_reduction) {
+  big_rational sum;
+  for (int i = 1; i <= 20; ++i) {
+    sum += big_rational(big_integer(1), big_integer(i * (i + 1)));
+  }
+  EXPECT_FALSE(sum.is_reduced());
+  EXPECT_EQ(big_rational(big_integer(20), big_integer(21)), sum);
+  big_rational const& view = sum;
+  EXPECT_EQ(20, view.numerator());
+  EXPECT_EQ("20/21", to_string(view));
+  EXPECT_FALSE(sum.is_reduced());
+  EXPECT_EQ(21, sum.denominator());
+  EXPECT_TRUE(sum.is_reduced());
+  big_rational p = big_rational(14) / big_rational(15);
+  p *= big_rational(25) / big_rational(28);
+  EXPECT_TRUE(p.is_reduced());
+  EXPECT_EQ("5/6", to_string(p));
+}
+
+TEST(correctness, rational_concurrent_reads) {
+  big_rational sum;
+  for (int i = 1; i <= 40; ++i) {
+    sum += big_rational(big_integer(1), big_integer(i * (i + 1)));
+  }
+  big_rational const& shared = sum;
+  std::vector<std::thread> threads;
+  std::vector<std::string> results(4);
+  for (size_t t = 0; t < results.size(); ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < 10; ++i) {
+        results[t] = to_string(shared.numerator()) + "/" +
+                     to_string(shared.denominator()) + " " + to_string(shared);
+      }
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+  for (std::string const& r : results) {
+    EXPECT_EQ("40/41 40/41", r);
+  }
+  EXPECT_FALSE(sum.is_reduced());
+}
+
+TEST(correctness, rational_compare) {
+  big_rational a(big_integer(1), big_integer(3));
+  big_rational b(big_integer(1), big_integer(2));
+  big_rational huge(big_integer("1" + std::string(60, '0')), big_integer(7));
+  EXPECT_TRUE(a < b);
+  EXPECT_TRUE(-b < -a);
+  EXPECT_TRUE(a < huge);
+  EXPECT_TRUE(-huge < -a);
+  EXPECT_TRUE(-a < big_rational());
+  EXPECT_TRUE(b >= a);
+  EXPECT_FALSE(a > b);
+  EXPECT_TRUE(a <= big_rational(big_integer(2), big_integer(6)));
+  EXPECT_TRUE(a != b);
+}
+
+TEST(correctness, float_rounding) {
+  // 2^53 + 1 does not fit in 53 bits, ties go to even
+  big_float a(big_integer("9007199254740993"), 0, 53);
+  EXPECT_EQ(big_float(big_integer("9007199254740992")), a);
+  big_float b(big_integer("9007199254740995"), 0, 53);
+  EXPECT_EQ(big_float(big_integer("9007199254740996")), b);
+  big_float third = big_float(1) / big_float(3);
+  EXPECT_EQ(64u, third.mantissa().bit_length());
+  EXPECT_EQ("0.3333333333", to_string(third, 10));
+  EXPECT_EQ("-0.6667", to_string(-third - third, 4));
+  EXPECT_THROW(third / big_float(), std::invalid_argument);
+}
+
+TEST(correctness, float_arithmetic) {
+  big_float big(big_integer(1), 1000);
+  big_float one(1);
+  EXPECT_EQ(big, big + one);
+  EXPECT_TRUE(big - one < big + big);
+  EXPECT_EQ(big_float(big_integer(3), -1), big_float(1) + big_float(big_integer(1), -1));
+  EXPECT_EQ(big_float(6), big_float(2) * big_float(3));
+  EXPECT_TRUE(big_float(-2) < big_float(big_integer(-3), -1));
+  EXPECT_EQ("1.5", to_string(big_float(big_integer(3), -1), 1));
+}
+
+TEST(correctness, float_sqrt) {
+  big_float two(big_integer(2), 0, 200);
+  EXPECT_EQ("1.41421356237309504880168872420969807856967187537695",
+            to_string(sqrt(two), 50));
+  EXPECT_EQ(big_float(12), sqrt(big_float(144)));
+  EXPECT_THROW(sqrt(big_float(-1)), std::invalid_argument);
+}
+
+TEST(correctness, pow_mod) {
+  EXPECT_EQ(445, pow_mod(4, 13, 497));
+  EXPECT_EQ(1, pow_mod(-1, 2, 7));
+  EXPECT_EQ(6, pow_mod(-1, 3, 7));
+  EXPECT_EQ(0, pow_mod(5, 3, 1));
+  EXPECT_EQ(376, pow_mod(2, 100, 1000));
+  big_integer p = (big_integer(1) << 127) - 1;
+  EXPECT_EQ(3, pow_mod(3, p, p));
+  EXPECT_THROW(pow_mod(2, -1, 7), std::invalid_argument);
+  EXPECT_THROW(pow_mod(2, 1, 0), std::invalid_argument);
+}
+
+TEST(correctness, montgomery_residues) {
+  big_integer n("340282366920938463463374607431768211507");
+  montgomery m(n);
+  montgomery::residue a = m.to_residue(big_integer("123456789123456789"));
+  montgomery::residue b = m.to_residue(-5);
+  montgomery::residue c;
+  m.mul(c, a, b);
+  EXPECT_EQ(big_integer("123456789123456789") * -5 % n + n, m.from_residue(c));
+  m.half(c, b);
+  m.add(c, c, c);
+  EXPECT_EQ(n - 5, m.from_residue(c));
+  EXPECT_THROW(montgomery(big_integer(10)), std::invalid_argument);
+}
+
+TEST(correctness, probable_prime) {
+  EXPECT_FALSE(is_probable_prime(0));
+  EXPECT_FALSE(is_probable_prime(1));
+  EXPECT_TRUE(is_probable_prime(2));
+  EXPECT_TRUE(is_probable_prime(2039));
+  EXPECT_FALSE(is_probable_prime(-7));
+  // Carmichael numbers and strong pseudoprimes to base 2
+  EXPECT_FALSE(is_probable_prime(561));
+  EXPECT_FALSE(is_probable_prime(41041));
+  EXPECT_FALSE(is_probable_prime(2047));
+  EXPECT_FALSE(is_probable_prime(big_integer("3215031751")));
+  EXPECT_FALSE(is_probable_prime(big_integer("3825123056546413051")));
+  EXPECT_FALSE(is_probable_prime(big_integer(4194301) * 4194301));
+  EXPECT_TRUE(is_probable_prime((big_integer(1) << 127) - 1));
+  EXPECT_TRUE(is_probable_prime((big_integer(1) << 521) - 1, 5));
+  EXPECT_FALSE(is_probable_prime((big_integer(1) << 523) - 1));
+  big_integer p("170141183460469231731687303715884105727");
+  big_integer q("618970019642690137449562111");
+  EXPECT_FALSE(is_probable_prime(p * q));
+}
+
+TEST(correctness, next_prime) {
+  EXPECT_EQ(2, next_prime(-10));
+  EXPECT_EQ(2, next_prime(1));
+  EXPECT_EQ(3, next_prime(2));
+  EXPECT_EQ(17, next_prime(13));
+  EXPECT_EQ(big_integer("18446744073709551629"),
+            next_prime(big_integer("18446744073709551616")));
+  big_integer p = (big_integer(1) << 127) - 1;
+  EXPECT_EQ(p, next_prime(p - 1));
+}
+
+TEST(correctness, batch_operations) {
+  // mixed sizes and signs, enough work to be split across threads
+  std::vector<big_integer> a, b;
+  big_integer x = (big_integer(1) << 3000) - 12345;
+  for (int i = 0; i < 300; ++i) {
+    big_integer y = x >> (i * 37 % 2900);
+    a.push_back(i % 3 == 0 ? -y : y);
+    b.push_back(i % 2 == 0 ? (x >> (i * 11 % 2900)) + i : -(x >> (i * 7)));
+  }
+  std::vector<big_integer> sum, product, remainder;
+  batch_add(sum, a, b);
+  batch_mul(product, a, b);
+  batch_mod(remainder, a, b);
+  ASSERT_EQ(a.size(), product.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    EXPECT_EQ(a[i] + b[i], sum[i]);
+    EXPECT_EQ(a[i] * b[i], product[i]);
+    EXPECT_EQ(a[i] % b[i], remainder[i]);
+  }
+  // the output may alias either operand
+  std::vector<big_integer> c = b;
+  batch_mod(c, a, c);
+  EXPECT_EQ(remainder, c);
+  c = a;
+  batch_mul(c, c, b);
+  EXPECT_EQ(product, c);
+  batch_add(c, a, a);
+  EXPECT_EQ(a[1] * 2, c[1]);
+  b.pop_back();
+  EXPECT_THROW(batch_add(c, a, b), std::invalid_argument);
+}
+
+TEST(correctness, native_operands) {
+  big_integer a("-340282366920938463463374607431768211456");
+  EXPECT_EQ(a + 1, a + big_integer(1));
+  EXPECT_EQ(1 - a, big_integer(1) - a);
+  EXPECT_EQ(a * INT64_MIN, a * big_integer(INT64_MIN));
+  EXPECT_EQ(a * UINT64_MAX, a * big_integer(UINT64_MAX));
+  EXPECT_EQ(a / -7, a / big_integer(-7));
+  EXPECT_EQ(a % 10000000000ull, a % big_integer(10000000000ull));
+  EXPECT_EQ(-6, a % -10);
+  EXPECT_EQ(-1, big_integer(-7) / 4);
+  EXPECT_THROW(a /= 0, std::invalid_argument);
+
+  EXPECT_TRUE(a < 0);
+  EXPECT_TRUE(a < INT64_MIN);
+  EXPECT_TRUE(UINT64_MAX > -a / 2 / UINT64_MAX / 2);
+  EXPECT_TRUE(big_integer(UINT64_MAX) == UINT64_MAX);
+  EXPECT_TRUE(big_integer(INT64_MIN) == INT64_MIN);
+  EXPECT_TRUE(big_integer(-1) != UINT64_MAX);
+  EXPECT_TRUE(0 <= big_integer(0));
+  EXPECT_FALSE(5 < big_integer(5));
+
+  big_integer b = 0;
+  b.reserve(4);
+  bigint_stats::reset();
+  for (int i = 0; i < 100; ++i) {
+    b *= 3;
+    b += UINT32_MAX;
+    b -= i;
+    b %= INT64_MAX;
+    --b;
+  }
+  EXPECT_TRUE(b > 0);
+  EXPECT_EQ(0u, bigint_stats::take().allocations);
+}
+
+TEST(correctness, transform_multiply) {
+  // (2^k - 1)^2 = 2^2k - 2^(k+1) + 1
+  size_t k = 32 * 3000 + 5;
+  big_integer a = (big_integer(1) << k) - 1;
+  EXPECT_EQ((big_integer(1) << 2 * k) - (big_integer(1) << (k + 1)) + 1, a * a);
+  big_integer b = -(a / 12345 + 777);
+  big_integer c = a * b;
+  EXPECT_EQ(a, c / b);
+  EXPECT_EQ(0, c % b);
+  EXPECT_EQ(-a, a * big_integer(-1));
+}
+
+TEST(correctness, mapped_allocator) {
+  using allocator = bigint_mmap::mapped_allocator<uint32_t>;
+  std::vector<uint32_t, allocator> v(bigint_mmap::MAP_THRESHOLD);
+  for (size_t i = 0; i < v.size(); ++i) {
+    v[i] = static_cast<uint32_t>(i);
+  }
+  v.resize(v.size() * 2, 7);
+  EXPECT_EQ(12345u, v[12345]);
+  EXPECT_EQ(7u, v.back());
+  std::string dir = bigint_mmap::directory();
+  bigint_mmap::set_directory("/nonexistent/directory");
+  EXPECT_THROW(allocator().allocate(bigint_mmap::MAP_THRESHOLD),
+               std::bad_alloc);
+  std::vector<uint32_t, allocator> small(100, 1);
+  EXPECT_EQ(100u, small.size());
+  bigint_mmap::set_directory(dir);
+}
@@ -0,0 +1,305 @@
+// Build and run:
+//   g++ -std=c++20 -O2 benchmarks.cpp -lbenchmark -pthread
+//   ./a.out --benchmark_out=before.json --benchmark_out_format=json
+// Two runs are compared with compare.py from the google-benchmark tools.
+// Adding -DVECTOR_PARALLEL builds the parallel bulk operations, which use
+// $VECTOR_THREADS threads if set.
+//
+// Each insert iteration inserts into the middle of a vector of 2^20
+// elements and erases what it inserted, so the size stays fixed. The
+// argument is the number of elements inserted at once; std::vector is the
+// baseline.
+//
+// The growth benchmarks push_back the argument number of ints into an empty
+// vector for each growth policy. They also report the peak resident memory
+// of one such fill above what was resident before it, read from VmHWM after
+// resetting it through /proc/self/clear_refs, and the capacity per element
+// at the end. The remap_allocator runs grow their block with mremap
+// instead of copying it. main pins the glibc mmap threshold for the whole
+// run, so that large blocks are always mapped and freed blocks are not
+// reused from the heap, which would hide them from the resident size, and
+// every benchmark runs under the same malloc configuration whatever the
+// filter.
+//
+// The fill benchmarks copy the argument number of bytes into an empty
+// vector<char> the way a reader would: byte by byte with push_back, with
+// append, or into space made by resize or resize_default_init.
+//
+// The nested benchmarks grow a vector of the argument number of vectors of
+// 16 ints, each built and then moved in, and copy-assign a vector of that
+// many ints to one that already has the capacity.
+//
+// The large copy benchmarks copy-construct vectors of the argument number
+// of ints or strings, the case the parallel bulk operations are for; they
+// are timed in real time since the copy runs on several threads.
+
+#include "benchmark/benchmark.h"
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <malloc.h>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "remap_allocator.h"
+#include "vector.h"
+
+namespace {
+constexpr size_t SIZE = size_t(1) << 20;
+
+template <typename V>
+using value_t = std::remove_pointer_t<decltype(std::declval<V&>().data())>;
+
+// VmRSS or VmHWM from /proc/self/status in bytes, 0 if unavailable
+size_t status_bytes(std::string const& key) {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, key.size() + 1, key + ":") == 0) {
+      return std::stoull(line.substr(key.size() + 1)) * 1024;
+    }
+  }
+  return 0;
+}
+
+template <typename T>
+T value(size_t i) {
+  if constexpr (std::is_same_v<T, std::string>) {
+    return std::to_string(i);
+  } else {
+    return T(i);
+  }
+}
+
+template <typename V>
+V filled(size_t n) {
+  V v;
+  v.reserve(SIZE + n);
+  for (size_t i = 0; i < SIZE; ++i) {
+    v.push_back(value<value_t<V>>(i));
+  }
+  return v;
+}
+
+template <typename V>
+void insert_middle(benchmark::State& state) {
+  size_t n = state.range(0);
+  V v = filled<V>(n);
+  for (auto _ : state) {
+    for (size_t i = 0; i < n; ++i) {
+      v.insert(v.begin() + SIZE / 2, value<value_t<V>>(i));
+    }
+    v.erase(v.begin() + SIZE / 2, v.begin() + SIZE / 2 + n);
+    benchmark::DoNotOptimize(v.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename V>
+void insert_range_middle(benchmark::State& state) {
+  size_t n = state.range(0);
+  V v = filled<V>(n);
+  std::vector<value_t<V>> src(n);
+  for (size_t i = 0; i < n; ++i) {
+    src[i] = value<value_t<V>>(i);
+  }
+  for (auto _ : state) {
+    v.insert(v.begin() + SIZE / 2, src.begin(), src.end());
+    v.erase(v.begin() + SIZE / 2, v.begin() + SIZE / 2 + n);
+    benchmark::DoNotOptimize(v.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename V>
+void insert_count_middle(benchmark::State& state) {
+  size_t n = state.range(0);
+  V v = filled<V>(n);
+  auto x = value<value_t<V>>(42);
+  for (auto _ : state) {
+    v.insert(v.begin() + SIZE / 2, n, x);
+    v.erase(v.begin() + SIZE / 2, v.begin() + SIZE / 2 + n);
+    benchmark::DoNotOptimize(v.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename V>
+void push_back_growth(benchmark::State& state) {
+  size_t n = state.range(0);
+  {
+    std::ofstream("/proc/self/clear_refs") << "5";
+    size_t base = status_bytes("VmRSS");
+    V v;
+    for (size_t i = 0; i < n; ++i) {
+      v.push_back(int(i));
+    }
+    size_t peak = status_bytes("VmHWM");
+    state.counters["peak_rss"] = double(peak > base ? peak - base : 0);
+    state.counters["capacity_per_element"] = double(v.capacity()) / n;
+  }
+  for (auto _ : state) {
+    V v;
+    for (size_t i = 0; i < n; ++i) {
+      v.push_back(int(i));
+    }
+    benchmark::DoNotOptimize(v.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+std::vector<char> bytes(size_t n) {
+  std::vector<char> res(n);
+  for (size_t i = 0; i < n; ++i) {
+    res[i] = char(i * 7);
+  }
+  return res;
+}
+
+void fill_push_back(benchmark::State& state) {
+  auto src = bytes(state.range(0));
+  for (auto _ : state) {
+    vector<char> v;
+    for (char c : src) {
+      v.push_back(c);
+    }
+    benchmark::DoNotOptimize(v.data());
+  }
+  state.SetBytesProcessed(state.iterations() * src.size());
+}
+
+void fill_append(benchmark::State& state) {
+  auto src = bytes(state.range(0));
+  for (auto _ : state) {
+    vector<char> v;
+    v.append(src.data(), src.data() + src.size());
+    benchmark::DoNotOptimize(v.data());
+  }
+  state.SetBytesProcessed(state.iterations() * src.size());
+}
+
+void fill_resize(benchmark::State& state) {
+  auto src = bytes(state.range(0));
+  for (auto _ : state) {
+    vector<char> v;
+    v.resize(src.size());
+    std::memcpy(v.data(), src.data(), src.size());
+    benchmark::DoNotOptimize(v.data());
+  }
+  state.SetBytesProcessed(state.iterations() * src.size());
+}
+
+void fill_resize_default_init(benchmark::State& state) {
+  auto src = bytes(state.range(0));
+  for (auto _ : state) {
+    vector<char> v;
+    v.resize_default_init(src.size());
+    std::memcpy(v.data(), src.data(), src.size());
+    benchmark::DoNotOptimize(v.data());
+  }
+  state.SetBytesProcessed(state.iterations() * src.size());
+}
+
+template <typename V>
+void nested_growth(benchmark::State& state) {
+  size_t n = state.range(0);
+  for (auto _ : state) {
+    V outer;
+    for (size_t i = 0; i < n; ++i) {
+      value_t<V> inner;
+      inner.resize(16, int(i));
+      outer.push_back(std::move(inner));
+    }
+    benchmark::DoNotOptimize(outer.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename V>
+void copy_assign(benchmark::State& state) {
+  size_t n = state.range(0);
+  V a;
+  a.resize(n, 1);
+  V b;
+  b.reserve(n);
+  for (auto _ : state) {
+    b = a;
+    benchmark::DoNotOptimize(b.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename V>
+void large_copy(benchmark::State& state) {
+  size_t n = state.range(0);
+  V a;
+  a.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    a.push_back(value<value_t<V>>(i));
+  }
+  for (auto _ : state) {
+    V b(a);
+    benchmark::DoNotOptimize(b.data());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+template <typename Growth>
+using growing = vector<int, std::allocator<int>, Growth>;
+} // namespace
+
+BENCHMARK(insert_middle<vector<int>>)->Range(1, 64);
+BENCHMARK(insert_middle<std::vector<int>>)->Range(1, 64);
+BENCHMARK(insert_middle<vector<std::string>>)->Range(1, 8);
+BENCHMARK(insert_middle<std::vector<std::string>>)->Range(1, 8);
+
+BENCHMARK(insert_range_middle<vector<int>>)->Range(1, 1 << 12);
+BENCHMARK(insert_range_middle<std::vector<int>>)->Range(1, 1 << 12);
+BENCHMARK(insert_range_middle<vector<std::string>>)->Range(1, 1 << 12);
+BENCHMARK(insert_range_middle<std::vector<std::string>>)->Range(1, 1 << 12);
+
+BENCHMARK(insert_count_middle<vector<int>>)->Range(1, 1 << 12);
+BENCHMARK(insert_count_middle<std::vector<int>>)->Range(1, 1 << 12);
+
+BENCHMARK(push_back_growth<growing<growth::doubling>>)->Range(1 << 12, 1 << 24);
+BENCHMARK(push_back_growth<growing<growth::one_and_half>>)
+    ->Range(1 << 12, 1 << 24);
+BENCHMARK(push_back_growth<growing<growth::size_class>>)
+    ->Range(1 << 12, 1 << 24);
+BENCHMARK(push_back_growth<growing<growth::page_granular>>)
+    ->Range(1 << 12, 1 << 24);
+BENCHMARK(push_back_growth<vector<int, remap_allocator<int>>>)
+    ->Range(1 << 12, 1 << 24);
+BENCHMARK(push_back_growth<std::vector<int>>)->Range(1 << 12, 1 << 24);
+
+BENCHMARK(fill_push_back)->Range(1 << 10, 1 << 24);
+BENCHMARK(fill_append)->Range(1 << 10, 1 << 24);
+BENCHMARK(fill_resize)->Range(1 << 10, 1 << 24);
+BENCHMARK(fill_resize_default_init)->Range(1 << 10, 1 << 24);
+
+BENCHMARK(nested_growth<vector<vector<int>>>)->Range(1 << 8, 1 << 20);
+BENCHMARK(nested_growth<std::vector<std::vector<int>>>)
+    ->Range(1 << 8, 1 << 20);
+
+BENCHMARK(copy_assign<vector<int>>)->Range(1 << 8, 1 << 20);
+BENCHMARK(copy_assign<std::vector<int>>)->Range(1 << 8, 1 << 20);
+
+BENCHMARK(large_copy<vector<int>>)->Range(1 << 20, 1 << 26)
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(large_copy<vector<std::string>>)->Range(1 << 20, 1 << 23)
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+int main(int argc, char** argv) {
+#ifdef __GLIBC__
+  mallopt(M_MMAP_THRESHOLD, growth::size_class::MMAP_THRESHOLD);
+#endif
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,206 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Chunked loops over the threads of a shared pool, used by vector for bulk
+// copies, fills and moves of large ranges when built with -DVECTOR_PARALLEL.
+// The pool has VECTOR_THREADS threads, the caller included, if that
+// environment variable is set, and one per hardware thread otherwise.
+namespace vector_parallel {
+// ranges of at least this many bytes are split across the pool
+constexpr size_t THRESHOLD = size_t(1) << 22;
+// chunks per thread, so that a thread done early takes over the rest
+constexpr size_t CHUNKS_PER_THREAD = 4;
+
+// Workers sleep until a job is posted, then take chunk indices from a shared
+// counter together with the caller, who returns once every chunk is done.
+// One job runs at a time; a job started from inside a chunk would wait for
+// itself, so for_chunks runs those on the calling thread.
+struct thread_pool {
+  // threads counts the caller
+  explicit thread_pool(size_t threads) {
+    for (size_t i = 1; i < threads; ++i) {
+      workers_.emplace_back([this] { work(); });
+    }
+  }
+
+  ~thread_pool() {
+    {
+      std::lock_guard lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& t : workers_) {
+      t.join();
+    }
+  }
+
+  size_t threads() const {
+    return workers_.size() + 1;
+  }
+
+  // whether the current thread is running a chunk
+  static bool inside() {
+    return inside_;
+  }
+
+  // task must not throw
+  void run(size_t count, std::function<void(size_t)> const& task) {
+    std::lock_guard job_lock(job_mutex_);
+    {
+      std::lock_guard lock(mutex_);
+      task_ = &task;
+      count_ = count;
+      next_ = 0;
+      done_ = 0;
+      ++generation_;
+    }
+    wake_.notify_all();
+    inside_ = true;
+    take_chunks();
+    inside_ = false;
+    std::unique_lock lock(mutex_);
+    finished_.wait(lock, [&] { return done_ == count_ && active_ == 0; });
+    task_ = nullptr;
+  }
+
+private:
+  std::vector<std::thread> workers_;
+  std::mutex job_mutex_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable finished_;
+  std::function<void(size_t)> const* task_ = nullptr;
+  size_t count_ = 0;
+  std::atomic<size_t> next_ = 0;
+  size_t done_ = 0;
+  // threads inside take_chunks, the next job waits for them to leave
+  size_t active_ = 0;
+  size_t generation_ = 0;
+  bool stop_ = false;
+  static inline thread_local bool inside_ = false;
+
+  void work() {
+    inside_ = true;
+    size_t seen = 0;
+    while (true) {
+      {
+        std::unique_lock lock(mutex_);
+        wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+        if (stop_) {
+          return;
+        }
+        seen = generation_;
+      }
+      take_chunks();
+    }
+  }
+
+  void take_chunks() {
+    size_t finished = 0;
+    std::function<void(size_t)> const* task;
+    size_t count;
+    {
+      std::lock_guard lock(mutex_);
+      if (task_ == nullptr) {
+        return;
+      }
+      task = task_;
+      count = count_;
+      ++active_;
+    }
+    for (size_t i; (i = next_.fetch_add(1)) < count; ++finished) {
+      (*task)(i);
+    }
+    std::lock_guard lock(mutex_);
+    done_ += finished;
+    if (--active_ == 0 && done_ == count_) {
+      finished_.notify_one();
+    }
+  }
+};
+
+inline size_t default_threads() {
+  if (char const* env = std::getenv("VECTOR_THREADS")) {
+    if (size_t n = std::strtoul(env, nullptr, 10); n != 0) {
+      return n;
+    }
+  }
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// never destroyed, so vectors with static storage duration can still use it
+// on exit
+inline thread_pool*& pool_instance() {
+  static thread_pool* instance = new thread_pool(default_threads());
+  return instance;
+}
+
+inline thread_pool& pool() {
+  return *pool_instance();
+}
+
+// Replaces the pool by one of the given number of threads, the caller
+// included, or of the default number for 0. It must not run a job then.
+inline void set_threads(size_t threads) {
+  thread_pool*& instance = pool_instance();
+  delete instance;
+  instance = nullptr;
+  instance = new thread_pool(threads != 0 ? threads : default_threads());
+}
+
+// Calls f(first, last) on consecutive chunks covering [0, size). A chunk
+// that throws must clean up after itself, as the serial loops do; the
+// remaining chunks are then skipped, undo(first, last) is called on the
+// calling thread for every chunk that completed, and the first exception is
+// rethrown. undo must not throw. Starting the pool or posting the job may
+// throw as well, but only before any chunk runs.
+template <typename F, typename Undo>
+void for_chunks(size_t size, F const& f, Undo const& undo) {
+  thread_pool& p = pool();
+  size_t chunks = std::min(size, p.threads() * CHUNKS_PER_THREAD);
+  if (chunks <= 1 || p.threads() == 1 || thread_pool::inside()) {
+    f(0, size);
+    return;
+  }
+  auto bound = [&](size_t c) {
+    return size / chunks * c + std::min(c, size % chunks);
+  };
+  std::vector<char> done(chunks);
+  std::atomic<bool> failed = false;
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  p.run(chunks, [&](size_t c) {
+    if (failed.load(std::memory_order_relaxed)) {
+      return;
+    }
+    try {
+      f(bound(c), bound(c + 1));
+      done[c] = 1;
+    } catch (...) {
+      failed = true;
+      std::lock_guard lock(error_mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  });
+  if (error) {
+    // on the calling thread, since handing it to the pool may throw
+    for (size_t c = 0; c < chunks; ++c) {
+      if (done[c]) {
+        undo(bound(c), bound(c + 1));
+      }
+    }
+    std::rethrow_exception(error);
+  }
+}
+} // namespace vector_parallel
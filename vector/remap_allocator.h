@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Blocks of at least MAP_THRESHOLD bytes are anonymous mappings that grow
+// and shrink with mremap, which moves page table entries instead of
+// copying, so resizing a huge block takes no second copy of the data and
+// the peak memory stays at the size of the block. Smaller blocks come from
+// malloc and are resized with realloc. A vector uses reallocate for
+// trivially relocatable elements and allocate/deallocate otherwise.
+template <typename T>
+struct remap_allocator {
+  using value_type = T;
+
+  static constexpr size_t MAP_THRESHOLD = size_t(1) << 20;
+
+  remap_allocator() = default;
+  template <typename U>
+  remap_allocator(remap_allocator<U> const&) noexcept {}
+
+  T* allocate(size_t n) {
+    size_t size = bytes(n);
+    void* p = (mapped(size) ? map(size) : std::malloc(size));
+    if (p == nullptr) {
+      throw std::bad_alloc();
+    }
+    return static_cast<T*>(p);
+  }
+
+  void deallocate(T* p, size_t n) noexcept {
+    size_t size = bytes(n);
+    if (mapped(size)) {
+      munmap(p, pages(size));
+    } else {
+      std::free(p);
+    }
+  }
+
+  // Moves the block of old_n elements to one of new_n elements, keeping the
+  // bytes of the first min(old_n, new_n); p stays valid if it throws.
+  T* reallocate(T* p, size_t old_n, size_t new_n) {
+    size_t old_size = bytes(old_n);
+    size_t new_size = bytes(new_n);
+    void* res;
+    if (mapped(old_size) && mapped(new_size)) {
+      res = mremap(p, pages(old_size), pages(new_size), MREMAP_MAYMOVE);
+      if (res == MAP_FAILED) {
+        throw std::bad_alloc();
+      }
+    } else if (!mapped(old_size) && !mapped(new_size)) {
+      res = std::realloc(p, new_size);
+      if (res == nullptr) {
+        throw std::bad_alloc();
+      }
+    } else {
+      // crossing the threshold copies once
+      res = allocate(new_n);
+      std::memcpy(res, static_cast<void const*>(p),
+                  (old_size < new_size ? old_size : new_size));
+      deallocate(p, old_n);
+    }
+    return static_cast<T*>(res);
+  }
+
+private:
+  static size_t bytes(size_t n) {
+    if (n > SIZE_MAX / sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+    return n * sizeof(T);
+  }
+
+  static bool mapped(size_t size) {
+    return size >= MAP_THRESHOLD;
+  }
+
+  static size_t pages(size_t size) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    return (size + page - 1) / page * page;
+  }
+
+  static void* map(size_t size) {
+    void* p = mmap(nullptr, pages(size), PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return (p == MAP_FAILED ? nullptr : p);
+  }
+};
+
+template <typename T, typename U>
+bool operator==(remap_allocator<T> const&, remap_allocator<U> const&) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(remap_allocator<T> const&, remap_allocator<U> const&) {
+  return false;
+}
@@ -1,8 +1,22 @@
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <malloc.h>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "gtest/gtest.h"
 
 #include "element.h"
+#include "parallel.h"
+#include "remap_allocator.h"
 #include "vector.h"
 
 template struct vector<int>;
@@ -48,6 +62,116 @@ TEST(correctness, push_back_from_self) {
   element<size_t>::expect_no_instances();
 }
 
+TEST(correctness, push_back_rvalue) {
+  size_t const N = 500;
+  vector<std::unique_ptr<size_t>> a;
+  for (size_t i = 0; i != N; ++i) {
+    auto p = std::make_unique<size_t>(i);
+    a.push_back(std::move(p));
+    EXPECT_EQ(nullptr, p);
+  }
+  for (size_t i = 0; i != N; ++i)
+    EXPECT_EQ(i, *a[i]);
+}
+
+namespace {
+struct copy_counter {
+  copy_counter() = default;
+  copy_counter(copy_counter const&) {
+    ++copies;
+  }
+  copy_counter(copy_counter&&) noexcept {}
+  copy_counter& operator=(copy_counter const&) = default;
+  copy_counter& operator=(copy_counter&&) noexcept = default;
+
+  static inline size_t copies = 0;
+};
+} // namespace
+
+TEST(correctness, reallocation_moves) {
+  size_t const N = 500;
+  vector<copy_counter> a;
+  copy_counter::copies = 0;
+  for (size_t i = 0; i != N; ++i)
+    a.emplace_back();
+  a.reserve(4 * N);
+  a.shrink_to_fit();
+  EXPECT_EQ(0, copy_counter::copies);
+}
+
+namespace {
+struct owner {
+  explicit owner(size_t value) : value(new size_t(value)) {}
+  owner(owner&& other) noexcept : value(other.value) {
+    other.value = nullptr;
+    ++moves;
+  }
+  ~owner() {
+    delete value;
+  }
+
+  size_t* value;
+  static inline size_t moves = 0;
+};
+} // namespace
+
+template <>
+struct is_trivially_relocatable<owner> : std::true_type {};
+
+TEST(correctness, trivially_relocatable) {
+  size_t const N = 500;
+  {
+    vector<owner> a;
+    owner::moves = 0;
+    for (size_t i = 0; i != N; ++i)
+      a.emplace_back(i);
+    a.reserve(4 * N);
+    a.shrink_to_fit();
+    EXPECT_EQ(0, owner::moves);
+    for (size_t i = 0; i != N; ++i)
+      EXPECT_EQ(i, *a[i].value);
+  }
+  EXPECT_TRUE(is_trivially_relocatable_v<int>);
+  EXPECT_FALSE(is_trivially_relocatable_v<std::string>);
+}
+
+TEST(correctness, trivial_copy) {
+  size_t const N = 5000;
+  vector<size_t> a;
+  for (size_t i = 0; i != N; ++i)
+    a.push_back(i * i);
+  vector<size_t> b = a;
+  a.shrink_to_fit();
+  for (size_t i = 0; i != N; ++i) {
+    EXPECT_EQ(i * i, a[i]);
+    EXPECT_EQ(i * i, b[i]);
+  }
+}
+
+TEST(correctness, emplace) {
+  vector<std::string> a;
+  EXPECT_EQ("aaa", a.emplace_back(3, 'a'));
+  a.emplace_back("ccc");
+  auto it = a.emplace(a.begin() + 1, 3, 'b');
+  EXPECT_EQ(a.begin() + 1, it);
+  a.insert(a.begin(), std::string(2, 'z'));
+  ASSERT_EQ(4, a.size());
+  EXPECT_EQ("zz", a[0]);
+  EXPECT_EQ("aaa", a[1]);
+  EXPECT_EQ("bbb", a[2]);
+  EXPECT_EQ("ccc", a[3]);
+}
+
+TEST(correctness, emplace_back_from_self) {
+  size_t const N = 500;
+  vector<std::string> a;
+  a.emplace_back(100, 'x');
+  for (size_t i = 0; i != N; ++i)
+    a.emplace_back(a[0]);
+  for (size_t i = 0; i != a.size(); ++i)
+    EXPECT_EQ(std::string(100, 'x'), a[i]);
+}
+
 TEST(correctness, subscription) {
   size_t const N = 500;
   vector<size_t> a;
@@ -77,7 +201,7 @@ TEST(correctness, data) {
   }
 
   {
-    element<size_t> const* cptr = as_const(a).data();
+    element<size_t> const* cptr = ::as_const(a).data();
     for (size_t i = 0; i != N; ++i)
       EXPECT_EQ(2 * i + 1, cptr[i]);
   }
@@ -90,10 +214,10 @@ TEST(correctness, front_back) {
     a.push_back(2 * i + 1);
 
   EXPECT_EQ(1, a.front());
-  EXPECT_EQ(1, as_const(a).front());
+  EXPECT_EQ(1, ::as_const(a).front());
 
   EXPECT_EQ(999, a.back());
-  EXPECT_EQ(999, as_const(a).back());
+  EXPECT_EQ(999, ::as_const(a).back());
 }
 
 TEST(correctness, capacity) {
@@ -250,6 +374,228 @@ TEST(correctness, insert_end) {
   element<size_t>::expect_no_instances();
 }
 
+TEST(correctness, insert_middle) {
+  size_t const N = 500;
+  {
+    vector<element<size_t>> a;
+    vector<size_t> b;
+    for (size_t i = 0; i != N; ++i) {
+      a.insert(a.begin() + a.size() / 2, i);
+      b.insert(b.begin() + b.size() / 2, i);
+    }
+    for (size_t i = 0; i != N; ++i)
+      EXPECT_EQ(b[i], a[i]);
+    EXPECT_EQ(N - 1, b[N / 2 - 1]);
+    EXPECT_EQ(N - 2, b[N / 2]);
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, insert_from_self) {
+  vector<std::string> a;
+  a.reserve(10);
+  for (size_t i = 0; i != 5; ++i)
+    a.push_back(std::string(100, char('a' + i)));
+  a.insert(a.begin(), a[3]);
+  a.insert(a.begin() + 1, 2, a.back());
+  EXPECT_EQ(8, a.size());
+  EXPECT_EQ(std::string(100, 'd'), a[0]);
+  EXPECT_EQ(std::string(100, 'e'), a[1]);
+  EXPECT_EQ(std::string(100, 'e'), a[2]);
+  EXPECT_EQ(std::string(100, 'a'), a[3]);
+}
+
+TEST(correctness, insert_count) {
+  {
+    for (size_t count : {0, 1, 3, 10, 40}) {
+      vector<element<size_t>> a;
+      a.reserve(20);
+      for (size_t i = 0; i != 10; ++i)
+        a.push_back(i);
+      element<size_t> value(42);
+      auto it = a.insert(a.begin() + 4, count, value);
+      EXPECT_EQ(a.begin() + 4, it);
+      EXPECT_EQ(10 + count, a.size());
+      for (size_t i = 0; i != a.size(); ++i) {
+        size_t expected = (i < 4 ? i : i < 4 + count ? 42 : i - count);
+        EXPECT_EQ(expected, a[i]);
+      }
+    }
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, insert_range) {
+  std::vector<int> src = {7, 8, 9, 10, 11, 12};
+  for (size_t pos = 0; pos <= 4; ++pos) {
+    for (size_t reserved : {0, 4, 16}) {
+      vector<int> a;
+      vector<element<int>> b;
+      a.reserve(reserved);
+      b.reserve(reserved);
+      for (int i = 0; i != 4; ++i) {
+        a.push_back(i);
+        b.push_back(i);
+      }
+      a.insert(a.begin() + pos, src.begin(), src.end());
+      b.insert(b.begin() + pos, src.begin(), src.end());
+      std::vector<int> expected = {0, 1, 2, 3};
+      expected.insert(expected.begin() + pos, src.begin(), src.end());
+      ASSERT_EQ(expected.size(), a.size());
+      ASSERT_EQ(expected.size(), b.size());
+      for (size_t i = 0; i != expected.size(); ++i) {
+        EXPECT_EQ(expected[i], a[i]);
+        EXPECT_EQ(expected[i], b[i]);
+      }
+    }
+  }
+  element<int>::expect_no_instances();
+}
+
+TEST(correctness, insert_input_range) {
+  std::istringstream in("4 5 6");
+  vector<int> a;
+  for (int i = 0; i != 4; ++i)
+    a.push_back(i);
+  auto it = a.insert(a.begin() + 2, std::istream_iterator<int>(in),
+                     std::istream_iterator<int>());
+  EXPECT_EQ(a.begin() + 2, it);
+  int expected[] = {0, 1, 4, 5, 6, 2, 3};
+  ASSERT_EQ(7, a.size());
+  for (size_t i = 0; i != 7; ++i)
+    EXPECT_EQ(expected[i], a[i]);
+}
+
+TEST(correctness, resize) {
+  {
+    vector<element<size_t>> a;
+    a.resize(10);
+    EXPECT_EQ(10, a.size());
+    a.resize(20, 7);
+    EXPECT_EQ(20, a.size());
+    EXPECT_EQ(7, a[10]);
+    EXPECT_EQ(7, a.back());
+    a.resize(15);
+    EXPECT_EQ(15, a.size());
+    EXPECT_EQ(7, a.back());
+    // the value may be an element that moves
+    a.resize(a.capacity() + 5, a.back());
+    EXPECT_EQ(7, a.back());
+    a.resize(0);
+    EXPECT_TRUE(a.empty());
+  }
+  element<size_t>::expect_no_instances();
+
+  vector<int> b;
+  b.resize(100);
+  for (size_t i = 0; i != 100; ++i)
+    EXPECT_EQ(0, b[i]);
+}
+
+TEST(correctness, resize_throw) {
+  {
+    vector<element<size_t>> a;
+    a.resize(3, 1);
+    size_t capacity = a.capacity();
+    element<size_t>::set_throw_countdown(5);
+    EXPECT_THROW(a.resize(capacity + 10, 2), std::runtime_error);
+    element<size_t>::set_throw_countdown(0);
+    EXPECT_EQ(3, a.size());
+    EXPECT_EQ(capacity, a.capacity());
+    EXPECT_EQ(1, a.back());
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, resize_default_init) {
+  vector<int> a;
+  a.resize_default_init(1000);
+  EXPECT_EQ(1000, a.size());
+  for (size_t i = 0; i != a.size(); ++i)
+    a[i] = int(i);
+  a.resize_default_init(500);
+  EXPECT_EQ(499, a.back());
+
+  vector<std::string> b;
+  b.push_back("x");
+  b.resize_default_init(3);
+  EXPECT_EQ("x", b[0]);
+  EXPECT_EQ("", b[2]);
+}
+
+TEST(correctness, append) {
+  vector<int> a;
+  int src[] = {1, 2, 3, 4};
+  a.append(src, src + 4);
+  std::vector<int> more(100, 5);
+  a.append(more.begin(), more.end());
+  std::istringstream in("6 7");
+  a.append(std::istream_iterator<int>(in), std::istream_iterator<int>());
+  ASSERT_EQ(106, a.size());
+  EXPECT_EQ(1, a[0]);
+  EXPECT_EQ(4, a[3]);
+  EXPECT_EQ(5, a[103]);
+  EXPECT_EQ(7, a[105]);
+
+  vector<std::string> b;
+  std::string strings[] = {"a", "b"};
+  b.append(strings, strings + 2);
+  b.append(strings, strings + 2);
+  ASSERT_EQ(4, b.size());
+  EXPECT_EQ("b", b[3]);
+}
+
+TEST(correctness, assign) {
+  {
+    vector<element<size_t>> a;
+    a.resize(10, 1);
+    a.assign(3, a[0]);
+    EXPECT_EQ(3, a.size());
+    EXPECT_EQ(1, a[2]);
+    std::vector<size_t> src = {4, 5, 6, 7, 8};
+    a.assign(src.begin(), src.end());
+    ASSERT_EQ(5, a.size());
+    EXPECT_EQ(4, a[0]);
+    EXPECT_EQ(8, a[4]);
+    a.assign(0, 3);
+    EXPECT_TRUE(a.empty());
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, insert_range_throw) {
+  {
+    vector<element<size_t>> a;
+    for (size_t i = 0; i != 10; ++i)
+      a.push_back(i);
+    size_t capacity = a.capacity();
+    vector<element<size_t>> b;
+    for (size_t i = 0; i != capacity; ++i)
+      b.push_back(100 + i);
+    element<size_t>::set_throw_countdown(capacity + 3);
+    EXPECT_THROW(a.insert(a.begin() + 5, b.begin(), b.end()),
+                 std::runtime_error);
+    element<size_t>::set_throw_countdown(0);
+    EXPECT_EQ(10, a.size());
+    EXPECT_EQ(capacity, a.capacity());
+    for (size_t i = 0; i != 10; ++i)
+      EXPECT_EQ(i, a[i]);
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, erase_trivial) {
+  vector<int> a;
+  for (int i = 0; i != 100; ++i)
+    a.push_back(i);
+  auto it = a.erase(a.begin() + 10, a.begin() + 30);
+  EXPECT_EQ(a.begin() + 10, it);
+  a.erase(a.begin());
+  EXPECT_EQ(79, a.size());
+  for (size_t i = 0; i != a.size(); ++i)
+    EXPECT_EQ(int(i < 9 ? i + 1 : i + 21), a[i]);
+}
+
 TEST(performance, insert) {
   const size_t N = 10000;
   vector<vector<int>> a;
@@ -470,6 +816,519 @@ TEST(correctness, assign_throw) {
   element<size_t>::expect_no_instances();
 }
 
+TEST(correctness, insert_middle_throw) {
+  {
+    vector<element<size_t>> a;
+    a.reserve(20);
+    for (size_t i = 0; i != 10; ++i)
+      a.push_back(i);
+    element<size_t>::set_throw_countdown(4);
+    EXPECT_THROW(a.insert(a.begin() + 2, element<size_t>(99)),
+                 std::runtime_error);
+    // basic: every element is still alive and the vector can be used
+    for (size_t i = 0; i != a.size(); ++i)
+      a[i] = element<size_t>(i);
+    a.insert(a.begin() + 2, element<size_t>(99));
+    EXPECT_EQ(element<size_t>(99), a[2]);
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, insert_end_throw) {
+  {
+    vector<element<size_t>> a;
+    a.reserve(20);
+    for (size_t i = 0; i != 10; ++i)
+      a.push_back(i);
+    element<size_t>::set_throw_countdown(3);
+    element<size_t> x(42);
+    EXPECT_THROW(a.insert(a.end(), 5, x), std::runtime_error);
+    element<size_t>::set_throw_countdown(0);
+    EXPECT_EQ(10, a.size());
+    for (size_t i = 0; i != 10; ++i)
+      EXPECT_EQ(element<size_t>(i), a[i]);
+  }
+  element<size_t>::expect_no_instances();
+}
+
+// Tells allocations apart by id and checks that every block is returned to
+// the allocator that made it.
+template <typename T, bool Propagate>
+struct tagged_allocator {
+  using value_type = T;
+  using propagate_on_container_copy_assignment =
+      std::bool_constant<Propagate>;
+  using propagate_on_container_swap = std::bool_constant<Propagate>;
+
+  int id;
+
+  explicit tagged_allocator(int id) : id(id) {}
+  template <typename U>
+  tagged_allocator(tagged_allocator<U, Propagate> const& other)
+      : id(other.id) {}
+
+  T* allocate(size_t n) {
+    T* p = std::allocator<T>().allocate(n);
+    owners()[p] = id;
+    return p;
+  }
+
+  void deallocate(T* p, size_t n) {
+    EXPECT_EQ(id, owners()[p]);
+    owners().erase(p);
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  static std::unordered_map<void*, int>& owners() {
+    static std::unordered_map<void*, int> owners;
+    return owners;
+  }
+
+  friend bool operator==(tagged_allocator const& a, tagged_allocator const& b) {
+    return a.id == b.id;
+  }
+
+  friend bool operator!=(tagged_allocator const& a, tagged_allocator const& b) {
+    return a.id != b.id;
+  }
+};
+
+template <bool Propagate>
+void check_allocator_propagation() {
+  using alloc_t = tagged_allocator<element<size_t>, Propagate>;
+  {
+    vector<element<size_t>, alloc_t> a(alloc_t(1));
+    for (size_t i = 0; i != 10; ++i)
+      a.push_back(i);
+    vector<element<size_t>, alloc_t> b(a);
+    EXPECT_EQ(1, b.get_allocator().id);
+
+    vector<element<size_t>, alloc_t> c(alloc_t(2));
+    c.push_back(42);
+    c = a;
+    EXPECT_EQ(Propagate ? 1 : 2, c.get_allocator().id);
+    EXPECT_EQ(10, c.size());
+    EXPECT_EQ(9, c.back());
+
+    if (Propagate) {
+      vector<element<size_t>, alloc_t> d(alloc_t(3));
+      d.push_back(7);
+      d.swap(a);
+      EXPECT_EQ(3, a.get_allocator().id);
+      EXPECT_EQ(1, d.get_allocator().id);
+      EXPECT_EQ(7, a[0]);
+    }
+  }
+  EXPECT_TRUE(alloc_t::owners().empty());
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, allocator_propagate) {
+  check_allocator_propagation<true>();
+}
+
+TEST(correctness, allocator_no_propagate) {
+  check_allocator_propagation<false>();
+}
+
+TEST(correctness, pmr_allocator) {
+  std::byte buffer[1 << 12];
+  std::pmr::monotonic_buffer_resource resource(
+      buffer, sizeof(buffer), std::pmr::null_memory_resource());
+  using string = std::pmr::string;
+  vector<string, std::pmr::polymorphic_allocator<string>> a(&resource);
+  for (size_t i = 0; i != 10; ++i)
+    a.push_back(string(40, char('a' + i)));
+  a.insert(a.begin() + 5, 2, string(40, 'z'));
+  EXPECT_EQ(12, a.size());
+  // the strings are constructed with the allocator of the vector
+  for (size_t i = 0; i != a.size(); ++i)
+    EXPECT_EQ(&resource, a[i].get_allocator().resource());
+  EXPECT_EQ(string(40, 'z'), a[6]);
+
+  // a copy does not inherit a polymorphic allocator
+  auto b = a;
+  EXPECT_EQ(std::pmr::get_default_resource(), b.get_allocator().resource());
+  EXPECT_EQ(std::pmr::get_default_resource(), b[0].get_allocator().resource());
+  EXPECT_EQ(a[11], b[11]);
+}
+
+template <typename Growth>
+std::vector<size_t> capacities(size_t n, size_t element_size = 1) {
+  std::vector<size_t> res;
+  for (size_t c = 0; res.size() < n;) {
+    c = Growth::next(c, c + 1, element_size);
+    res.push_back(c);
+  }
+  return res;
+}
+
+TEST(correctness, growth_policies) {
+  EXPECT_EQ((std::vector<size_t>{1, 3, 7, 15, 31}),
+            capacities<growth::doubling>(5));
+  EXPECT_EQ((std::vector<size_t>{1, 2, 4, 7, 11, 17}),
+            capacities<growth::one_and_half>(6));
+
+  for (size_t c : capacities<growth::page_granular>(40, sizeof(int))) {
+    if (c * sizeof(int) >= growth::page_granular::THRESHOLD) {
+      EXPECT_EQ(0, c * sizeof(int) % growth::page_granular::PAGE);
+    }
+  }
+  for (size_t c : capacities<growth::size_class>(40, 24)) {
+    // the next element would need a larger class
+    EXPECT_GT((c + 1) * 24, growth::size_class::usable_size(c * 24));
+  }
+  // the policy also applies to insertions that overflow the capacity
+  vector<int, std::allocator<int>, growth::one_and_half> a;
+  a.insert(a.begin(), 3, 0);
+  EXPECT_EQ(3, a.capacity());
+  a.insert(a.begin(), 2, 1);
+  EXPECT_EQ(5, a.capacity());
+}
+
+TEST(correctness, size_class_growth) {
+  vector<int, std::allocator<int>, growth::size_class> a;
+  size_t reallocations = 0;
+  for (int i = 0; i != 100000; ++i) {
+    int const* data = a.data();
+    a.push_back(i);
+    if (data == a.data())
+      continue;
+    ++reallocations;
+#if defined(__GLIBC__) && !defined(VECTOR_JEMALLOC) &&                        \
+    !defined(__SANITIZE_ADDRESS__)
+    // hardly any slack is left in the blocks malloc gives out
+    EXPECT_GT(a.capacity() * sizeof(int) + 16, malloc_usable_size(a.data()));
+#endif
+  }
+  EXPECT_GE(18, reallocations);
+  for (int i = 0; i != 100000; ++i)
+    EXPECT_EQ(i, a[i]);
+}
+
+TEST(correctness, remap_allocator) {
+  size_t const N = 1 << 20;
+  vector<size_t, remap_allocator<size_t>> a;
+  for (size_t i = 0; i != N; ++i) {
+    a.push_back(i);
+    if (i % 100000 == 0)
+      a.push_back(a.back());
+  }
+  size_t k = 3 * a.capacity();
+  a.insert(a.begin() + 1, k, 42);
+  EXPECT_EQ(42, a[k]);
+  a.erase(a.begin() + 1, a.begin() + 1 + k);
+  ASSERT_EQ(N + 11, a.size());
+  a.shrink_to_fit();
+  EXPECT_EQ(N + 11, a.capacity());
+  size_t j = 0;
+  for (size_t i = 0; i != N; ++i) {
+    EXPECT_EQ(i, a[j++]);
+    if (i % 100000 == 0) {
+      EXPECT_EQ(i, a[j++]);
+    }
+  }
+
+  // back below the mapping threshold
+  a.erase(a.begin() + 10, a.end());
+  a.shrink_to_fit();
+  vector<size_t, remap_allocator<size_t>> b = a;
+  for (size_t i = 0; i != 10; ++i)
+    EXPECT_EQ(a[i], b[i]);
+  a.clear();
+  a.shrink_to_fit();
+  EXPECT_EQ(nullptr, a.data());
+
+  // an argument referring to an element survives the block moving
+  vector<size_t, remap_allocator<size_t>> d;
+  d.reserve(N);
+  for (size_t i = 0; i != N; ++i)
+    d.push_back(i + 1);
+  d.push_back(d[N - 1]);
+  EXPECT_EQ(N, d.back());
+  d.insert(d.end(), d.capacity(), d[0]);
+  EXPECT_EQ(1, d.back());
+
+  // elements that are not trivially relocatable are copied as usual
+  vector<std::string, remap_allocator<std::string>> c;
+  for (size_t i = 0; i != 100; ++i)
+    c.push_back(std::string(20, 'a'));
+  EXPECT_EQ(std::string(20, 'a'), c[99]);
+}
+
+static_assert(std::is_nothrow_move_constructible_v<vector<std::string>>);
+static_assert(std::is_nothrow_move_assignable_v<vector<std::string>>);
+static_assert(std::is_nothrow_swappable_v<vector<std::string>>);
+
+TEST(correctness, move_ctor) {
+  {
+    vector<element<size_t>> a;
+    for (size_t i = 0; i != 10; ++i)
+      a.push_back(i);
+    element<size_t> const* data = a.data();
+    vector<element<size_t>> b(std::move(a));
+    EXPECT_EQ(data, b.data());
+    EXPECT_EQ(10, b.size());
+    EXPECT_EQ(nullptr, a.data());
+    EXPECT_TRUE(a.empty());
+    EXPECT_EQ(0, a.capacity());
+    a.push_back(3);
+    EXPECT_EQ(3, a[0]);
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, move_assignment) {
+  {
+    vector<element<size_t>> a;
+    for (size_t i = 0; i != 10; ++i)
+      a.push_back(i);
+    vector<element<size_t>> b;
+    b.push_back(42);
+    element<size_t> const* data = a.data();
+    b = std::move(a);
+    EXPECT_EQ(data, b.data());
+    EXPECT_EQ(9, b.back());
+    EXPECT_TRUE(a.empty());
+    b = std::move(b);
+    EXPECT_EQ(10, b.size());
+  }
+  element<size_t>::expect_no_instances();
+}
+
+TEST(correctness, move_assignment_other_allocator) {
+  using alloc_t = tagged_allocator<std::string, false>;
+  {
+    vector<std::string, alloc_t> a(alloc_t(1));
+    a.push_back(std::string(100, 'a'));
+    vector<std::string, alloc_t> b(alloc_t(2));
+    b = std::move(a);
+    EXPECT_EQ(2, b.get_allocator().id);
+    ASSERT_EQ(1, b.size());
+    EXPECT_EQ(std::string(100, 'a'), b[0]);
+    // the string itself was moved
+    EXPECT_EQ("", a[0]);
+  }
+  EXPECT_TRUE(alloc_t::owners().empty());
+}
+
+TEST(correctness, copy_assignment_reuses_storage) {
+  vector<int> a;
+  for (int i = 0; i != 10; ++i)
+    a.push_back(i);
+  vector<int> b;
+  b.reserve(100);
+  b.push_back(-1);
+  int const* data = b.data();
+  b = a;
+  EXPECT_EQ(data, b.data());
+  EXPECT_EQ(100, b.capacity());
+  EXPECT_EQ(10, b.size());
+  EXPECT_EQ(9, b.back());
+
+  // a larger source needs a new buffer of exactly its size
+  a.resize(200, 5);
+  b = a;
+  EXPECT_EQ(200, b.capacity());
+  EXPECT_EQ(5, b.back());
+}
+
+TEST(correctness, swap_free_function) {
+  vector<int> a, b;
+  a.push_back(1);
+  b.push_back(2);
+  b.push_back(3);
+  int const* data = a.data();
+  using std::swap;
+  swap(a, b);
+  EXPECT_EQ(data, b.data());
+  EXPECT_EQ(2, a.size());
+  EXPECT_EQ(1, b[0]);
+}
+
+// Gives the shared pool a fixed number of threads, so that the parallel
+// paths run concurrently even on a single core machine, and restores the
+// default on destruction.
+struct pool_threads {
+  explicit pool_threads(size_t threads) {
+    vector_parallel::set_threads(threads);
+  }
+
+  ~pool_threads() {
+    vector_parallel::set_threads(0);
+  }
+};
+
+TEST(correctness, for_chunks) {
+  pool_threads threads(4);
+  EXPECT_EQ(4, vector_parallel::pool().threads());
+  for (size_t size : {0, 1, 7, 1000003}) {
+    std::vector<int> hits(size);
+    vector_parallel::for_chunks(
+        size,
+        [&](size_t first, size_t last) {
+          for (size_t i = first; i != last; ++i)
+            ++hits[i];
+        },
+        [](size_t, size_t) { FAIL(); });
+    for (size_t i = 0; i != size; ++i)
+      EXPECT_EQ(1, hits[i]);
+  }
+}
+
+TEST(correctness, for_chunks_throw) {
+  pool_threads threads(4);
+  std::thread::id caller = std::this_thread::get_id();
+  std::mutex m;
+  std::vector<std::pair<size_t, size_t>> completed, undone;
+  EXPECT_THROW(vector_parallel::for_chunks(
+                   1000,
+                   [&](size_t first, size_t last) {
+                     if (first <= 500 && 500 < last)
+                       throw std::runtime_error("chunk failed");
+                     std::lock_guard lock(m);
+                     completed.emplace_back(first, last);
+                   },
+                   [&](size_t first, size_t last) {
+                     EXPECT_EQ(caller, std::this_thread::get_id());
+                     undone.emplace_back(first, last);
+                   }),
+               std::runtime_error);
+  std::sort(completed.begin(), completed.end());
+  std::sort(undone.begin(), undone.end());
+  EXPECT_FALSE(completed.empty());
+  EXPECT_EQ(completed, undone);
+}
+
+// A copy counter that may be used from several threads.
+struct shared_counted {
+  shared_counted(size_t val) : val(val) {
+    ++live;
+  }
+
+  shared_counted(shared_counted const& other) : val(other.val) {
+    if (val == throw_at)
+      throw std::runtime_error("copy failed");
+    ++live;
+  }
+
+  ~shared_counted() {
+    --live;
+  }
+
+  size_t val;
+  static inline std::atomic<long> live = 0;
+  static inline size_t throw_at = SIZE_MAX;
+};
+
+TEST(correctness, large_copy_assign_reuse) {
+  pool_threads threads(4);
+  size_t const N = vector_parallel::THRESHOLD / sizeof(int) * 2;
+  vector<int> a, b;
+  a.resize(N, 1);
+  b.reserve(N);
+  b.resize(N / 4, 2);
+  int const* data = b.data();
+  b = a;
+  EXPECT_EQ(data, b.data());
+  EXPECT_EQ(N, b.size());
+  EXPECT_EQ(N, size_t(std::count(b.begin(), b.end(), 1)));
+}
+
+TEST(correctness, large_copy_throw) {
+  pool_threads threads(4);
+  size_t const N = vector_parallel::THRESHOLD / sizeof(shared_counted) + 1000;
+  {
+    vector<shared_counted> a;
+    a.reserve(N);
+    for (size_t i = 0; i != N; ++i)
+      a.push_back(i);
+    EXPECT_EQ(N, shared_counted::live);
+
+    shared_counted::throw_at = N / 3;
+    EXPECT_THROW({ vector<shared_counted> b(a); }, std::runtime_error);
+    EXPECT_EQ(N, shared_counted::live);
+    vector<shared_counted> c;
+    EXPECT_THROW(c.assign(a.begin(), a.end()), std::runtime_error);
+    EXPECT_EQ(N, shared_counted::live);
+    shared_counted::throw_at = SIZE_MAX;
+
+    vector<shared_counted> b(a);
+    EXPECT_EQ(2 * N, shared_counted::live);
+    for (size_t i = 0; i != N; ++i)
+      EXPECT_EQ(i, b[i].val);
+    b.reserve(2 * N);
+    EXPECT_EQ(2 * N, shared_counted::live);
+    EXPECT_EQ(N - 1, b.back().val);
+  }
+  EXPECT_EQ(0, shared_counted::live);
+}
+
+// Records the threads that construct elements through it.
+template <typename T>
+struct recording_allocator : std::allocator<T> {
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = recording_allocator<U>;
+  };
+
+  recording_allocator() = default;
+  template <typename U>
+  recording_allocator(recording_allocator<U> const&) {}
+
+  template <typename... Args>
+  void construct(T* p, Args&&... args) {
+    {
+      std::lock_guard lock(mutex());
+      threads().insert(std::this_thread::get_id());
+    }
+    new (p) T(std::forward<Args>(args)...);
+  }
+
+  void destroy(T* p) {
+    p->~T();
+  }
+
+  static std::mutex& mutex() {
+    static std::mutex m;
+    return m;
+  }
+
+  static std::unordered_set<std::thread::id>& threads() {
+    static std::unordered_set<std::thread::id> ids;
+    return ids;
+  }
+};
+
+static_assert(allows_concurrent_construct<std::allocator<int>>::value);
+static_assert(allows_concurrent_construct<remap_allocator<int>>::value);
+static_assert(!allows_concurrent_construct<recording_allocator<int>>::value);
+static_assert(!allows_concurrent_construct<
+              std::pmr::polymorphic_allocator<std::pmr::string>>::value);
+
+TEST(correctness, large_copy_allocator_construct) {
+  pool_threads threads(4);
+  size_t const N = vector_parallel::THRESHOLD / sizeof(std::string) + 1000;
+  using alloc_t = recording_allocator<std::string>;
+  vector<std::string, alloc_t> a;
+  a.resize(N, std::string(40, 'a'));
+  alloc_t::threads().clear();
+  vector<std::string, alloc_t> b(a);
+  EXPECT_EQ(1, alloc_t::threads().size());
+  EXPECT_EQ(std::string(40, 'a'), b[N - 1]);
+
+  // a monotonic resource is not synchronized, so the copy stays serial
+  std::pmr::monotonic_buffer_resource resource;
+  using string = std::pmr::string;
+  vector<string, std::pmr::polymorphic_allocator<string>> c(&resource);
+  c.resize(N, string(40, 'c'));
+  vector<string, std::pmr::polymorphic_allocator<string>> d(
+      c, c.get_allocator());
+  EXPECT_EQ(string(40, 'c'), d[N - 1]);
+  EXPECT_EQ(&resource, d[N - 1].get_allocator().resource());
+}
 
 TEST(correctness, iter_types) {
   using el_t = element<size_t>;
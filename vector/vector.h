@@ -1,14 +1,167 @@
 #pragma once
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifdef VECTOR_JEMALLOC
+#include <jemalloc/jemalloc.h>
+#endif
+
+#ifdef VECTOR_PARALLEL
+#include "parallel.h"
+#endif
+
+// Objects of a trivially relocatable type can be moved to another address
+// by copying their bytes, after which the original is not destroyed. This
+// holds for trivially copyable types and for most types that own their
+// resources through pointers; specialize it as true_type to opt such a type
+// in.
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v =
+    is_trivially_relocatable<T>::value;
+
+// An allocator with a member reallocate(p, old_n, new_n) that moves a
+// block to a new size keeping its bytes, like realloc, lets vectors of
+// trivially relocatable elements grow without allocating a second block
+// next to the first (see remap_allocator.h).
+template <typename Allocator, typename = void>
+struct has_reallocate : std::false_type {};
+
+template <typename Allocator>
+struct has_reallocate<
+    Allocator, std::void_t<decltype(std::declval<Allocator&>().reallocate(
+                   std::declval<typename Allocator::value_type*>(), size_t(),
+                   size_t()))>> : std::true_type {};
+
+// Whether the allocator has its own construct member instead of the
+// default of std::allocator_traits.
+template <typename Allocator, typename = void>
+struct has_construct : std::false_type {};
+
+template <typename Allocator>
+struct has_construct<
+    Allocator, std::void_t<decltype(std::declval<Allocator&>().construct(
+                   std::declval<typename Allocator::value_type*>(),
+                   std::declval<typename Allocator::value_type>()))>>
+    : std::true_type {};
+
+// Whether elements may be constructed through the allocator from several
+// threads at once, which the parallel bulk copies of -DVECTOR_PARALLEL
+// need. The default construct only runs the element's constructor; an
+// allocator with its own, like std::pmr::polymorphic_allocator drawing
+// from an unsynchronized memory resource, is used from one thread unless
+// this is specialized as true_type.
+template <typename Allocator>
+struct allows_concurrent_construct
+    : std::bool_constant<!has_construct<Allocator>::value> {};
+
+// whose construct, deprecated before C++20, is the default one
+template <typename T>
+struct allows_concurrent_construct<std::allocator<T>> : std::true_type {};
+
+namespace growth {
+// Growth policies choose the capacity to reallocate to when `required`
+// elements of `element_size` bytes do not fit in `capacity`; it is at least
+// `required`. reserve and shrink_to_fit stay exact.
+
+// 2n + 1, at most half of the memory is unused
+struct doubling {
+  static size_t next(size_t capacity, size_t required, size_t) {
+    return std::max(2 * capacity + 1, required);
+  }
+};
 
-template <typename T>
+// 1.5n + 1, at most a third unused, and the blocks freed by earlier
+// reallocations can eventually be reused for a new one
+struct one_and_half {
+  static size_t next(size_t capacity, size_t required, size_t) {
+    return std::max(capacity + capacity / 2 + 1, required);
+  }
+};
+
+// Doubles and hands the slack of the malloc size class the block falls
+// into over to the capacity. The classes are taken from nallocx with
+// -DVECTOR_JEMALLOC and follow the glibc chunk layout otherwise: 16-byte
+// steps with an 8-byte header, and whole pages for blocks large enough to
+// be mapped.
+struct size_class {
+  static size_t next(size_t capacity, size_t required, size_t element_size) {
+    size_t n = doubling::next(capacity, required, element_size);
+    return usable_size(n * element_size) / element_size;
+  }
+
+  static size_t usable_size(size_t bytes) {
+#ifdef VECTOR_JEMALLOC
+    return nallocx(bytes, 0);
+#else
+    size_t chunk = std::max<size_t>(32, (bytes + 8 + 15) & ~size_t(15));
+    if (chunk < MMAP_THRESHOLD) {
+      return chunk - 8;
+    }
+    // the largest request whose chunk and header still fit in the pages
+    return (chunk + 8 + PAGE - 1) / PAGE * PAGE - 24;
+#endif
+  }
+
+  static constexpr size_t PAGE = 4096;
+  // the initial M_MMAP_THRESHOLD of glibc
+  static constexpr size_t MMAP_THRESHOLD = 128 << 10;
+};
+
+// Doubles small vectors, then grows by half and rounds blocks from the
+// threshold on up to whole pages, so a huge vector wastes at most a third
+// plus a page and its blocks map onto pages.
+struct page_granular {
+  static size_t next(size_t capacity, size_t required, size_t element_size) {
+    size_t n = (capacity * element_size < THRESHOLD
+                    ? doubling::next(capacity, required, element_size)
+                    : one_and_half::next(capacity, required, element_size));
+    size_t bytes = n * element_size;
+    if (bytes >= THRESHOLD) {
+      bytes = (bytes + PAGE - 1) / PAGE * PAGE;
+    }
+    return bytes / element_size;
+  }
+
+  static constexpr size_t PAGE = 4096;
+  static constexpr size_t THRESHOLD = 1 << 20;
+};
+} // namespace growth
+
+// Memory and construction go through std::allocator_traits<Allocator>. The
+// allocator is copied on copy construction as
+// select_on_container_copy_construction says, and replaced on copy
+// assignment and swap only when the matching propagate_on_container_* trait
+// is set; otherwise swapping vectors with unequal allocators is undefined,
+// as for std::vector. Allocators must use plain pointers. Growth is one of
+// the policies above.
+template <typename T, typename Allocator = std::allocator<T>,
+          typename Growth = growth::doubling>
 struct vector {
+  using value_type = T;
+  using allocator_type = Allocator;
+  using growth_policy = Growth;
   using iterator = T*;
   using const_iterator = T const*;
 
-  vector();                               // O(1) nothrow
-  vector(vector const&);                  // O(N) strong
-  vector& operator=(vector const& other); // O(N) strong
+  vector();                                // O(1) nothrow
+  explicit vector(Allocator const&);       // O(1) nothrow
+  vector(vector const&);                   // O(N) strong
+  vector(vector const&, Allocator const&); // O(N) strong
+  vector(vector&&) noexcept;               // O(1) nothrow
+  vector& operator=(vector const& other);  // O(N) strong
+  vector& operator=(vector&& other) noexcept(
+      moves_storage); // O(N) nothrow if moves_storage, basic otherwise
+
+  Allocator get_allocator() const; // O(1) nothrow
 
   ~vector(); // O(N) nothrow
 
@@ -25,17 +178,35 @@ struct vector {
   T& back();                // O(1) nothrow
   T const& back() const;    // O(1) nothrow
   void push_back(T const&); // O(1)* strong
+  void push_back(T&&);      // O(1)* strong
   void pop_back();          // O(1) nothrow
 
+  template <typename... Args>
+  T& emplace_back(Args&&... args); // O(1)* strong
+
   bool empty() const; // O(1) nothrow
 
   size_t capacity() const; // O(1) nothrow
   void reserve(size_t);    // O(N) strong
   void shrink_to_fit();    // O(N) strong
 
+  void resize(size_t);              // O(N)* strong
+  void resize(size_t, T const&);    // O(N)* strong
+  void resize_default_init(size_t); // O(N)* strong
+
+  template <typename InputIt,
+            typename = std::enable_if_t<!std::is_integral_v<InputIt>>>
+  void append(InputIt first, InputIt last); // O(M)* strong
+
+  void assign(size_t count, T const&); // O(N + count) basic
+
+  template <typename InputIt,
+            typename = std::enable_if_t<!std::is_integral_v<InputIt>>>
+  void assign(InputIt first, InputIt last); // O(N + M) basic
+
   void clear(); // O(N) nothrow
 
-  void swap(vector&); // O(1) nothrow
+  void swap(vector&) noexcept; // O(1) nothrow
 
   iterator begin(); // O(1) nothrow
   iterator end();   // O(1) nothrow
@@ -43,248 +214,797 @@ struct vector {
   const_iterator begin() const; // O(1) nothrow
   const_iterator end() const;   // O(1) nothrow
 
-  iterator insert(const_iterator pos, T const&); // O(N) strong
+  // Inserting at the end, into a full vector, or elements of a trivially
+  // relocatable type is strong; otherwise the tail is shifted by moves and
+  // assignments, and a throwing one leaves the vector valid but changed,
+  // as for std::vector.
+  iterator insert(const_iterator pos, T const&); // O(N) basic
+  iterator insert(const_iterator pos, T&&);      // O(N) basic
+
+  iterator insert(const_iterator pos, size_t count,
+                  T const& element); // O(N + count) basic
 
-  iterator erase(const_iterator pos); // O(N) nothrow(swap)
+  template <typename InputIt,
+            typename = std::enable_if_t<!std::is_integral_v<InputIt>>>
+  iterator insert(const_iterator pos, InputIt first,
+                  InputIt last); // O(N + M) basic
+
+  template <typename... Args>
+  iterator emplace(const_iterator pos, Args&&... args); // O(N) basic
+
+  iterator erase(const_iterator pos); // O(N) nothrow(move)
 
   iterator erase(const_iterator first,
-                 const_iterator last); // O(N) nothrow(swap)
+                 const_iterator last); // O(N) nothrow(move)
 
 private:
+  using alloc_traits = std::allocator_traits<Allocator>;
+  static_assert(std::is_same_v<typename alloc_traits::pointer, T*>,
+                "allocators with fancy pointers are not supported");
+  static constexpr bool reallocates =
+      is_trivially_relocatable_v<T> && has_reallocate<Allocator>::value;
+  // move assignment takes over the buffer instead of moving the elements
+  static constexpr bool moves_storage =
+      alloc_traits::propagate_on_container_move_assignment::value ||
+      alloc_traits::is_always_equal::value;
+
+  void release() noexcept;
+
+  T* allocate(size_t);
+  void deallocate(T*, size_t);
+  void swap_storage(vector&);
   void ensure_capacity(size_t);
 
+  template <typename Construct, typename Assign>
+  iterator insert_n(size_t pos, size_t count, Construct construct,
+                    Assign assign);
+
 private:
   T* data_;
   size_t size_;
   size_t capacity_;
+  [[no_unique_address]] Allocator alloc_;
 };
 
-template <typename T>
-void remove_elements(T* data, const size_t size) {
-  for (size_t i = 0; i < size; ++i) {
-    data[i].~T();
+// a vector only refers to its elements through a pointer, so it is as
+// relocatable as its allocator
+template <typename T, typename Allocator, typename Growth>
+struct is_trivially_relocatable<vector<T, Allocator, Growth>>
+    : std::bool_constant<std::is_empty_v<Allocator> ||
+                         is_trivially_relocatable_v<Allocator>> {};
+
+// found by argument-dependent lookup in place of the three moves of std::swap
+template <typename T, typename Allocator, typename Growth>
+void swap(vector<T, Allocator, Growth>& a,
+          vector<T, Allocator, Growth>& b) noexcept {
+  a.swap(b);
+}
+
+// Runs f(first, last) over [0, size), split across the threads of
+// vector_parallel::pool() when built with -DVECTOR_PARALLEL, Parallel is
+// set and the range is large. A failing part cleans up after itself;
+// undo(first, last) then reverts the parts that completed, as
+// vector_parallel::for_chunks says.
+template <typename T, bool Parallel, typename F, typename Undo>
+void for_elements(size_t size, F const& f, [[maybe_unused]] Undo const& undo) {
+#ifdef VECTOR_PARALLEL
+  if (Parallel && size * sizeof(T) >= vector_parallel::THRESHOLD) {
+    vector_parallel::for_chunks(size, f, undo);
+    return;
   }
+#endif
+  f(0, size);
 }
 
-template <typename T>
-void copy_elements(T const* from, T* to, const size_t size, T const* element = nullptr) {
-  size_t ind = 0;
-  try {
-    for (; ind < size; ++ind) {
-      new (to + ind) T(from[ind]);
+// The element helpers construct and destroy through the allocator. Bulk
+// copies of trivially copyable or relocatable elements bypass it, like the
+// memmove paths of the standard containers.
+
+// Runs on the calling thread, since handing work to the pool may throw and
+// destruction must not.
+template <typename Allocator, typename T>
+void remove_elements(Allocator& alloc, T* data, const size_t size) {
+  if constexpr (!std::is_trivially_destructible_v<T>) {
+    for (size_t i = 0; i < size; ++i) {
+      std::allocator_traits<Allocator>::destroy(alloc, data + i);
     }
-    if (element != nullptr)
-      new (to + size) T(*element);
-  } catch (...) {
-    remove_elements(to, ind);
-    throw;
   }
 }
 
+// Calls construct(to + i, i) for every i < size; if one throws, the
+// elements made so far are destroyed.
+template <typename Allocator, typename T, typename Construct>
+void construct_each(Allocator& alloc, T* to, const size_t size,
+                    Construct const& construct) {
+  for_elements<T, allows_concurrent_construct<Allocator>::value>(
+      size,
+      [&](size_t first, size_t last) {
+        size_t ind = first;
+        try {
+          for (; ind < last; ++ind) {
+            construct(to + ind, ind);
+          }
+        } catch (...) {
+          remove_elements(alloc, to + first, ind - first);
+          throw;
+        }
+      },
+      [&](size_t first, size_t last) {
+        remove_elements(alloc, to + first, last - first);
+      });
+}
+
 template <typename T>
-void vector<T>::ensure_capacity(size_t new_capacity) {
+void copy_bytes(T const* from, T* to, const size_t size) {
+  if (size != 0) {
+    for_elements<T, true>(
+        size,
+        [&](size_t first, size_t last) {
+          std::memcpy(static_cast<void*>(to + first),
+                      static_cast<void const*>(from + first),
+                      sizeof(T) * (last - first));
+        },
+        [](size_t, size_t) {});
+  }
+}
+
+// Constructs the elements from the same arguments, so with none they are
+// value-initialized.
+template <typename Allocator, typename T, typename... Args>
+void construct_elements(Allocator& alloc, T* to, const size_t size,
+                        Args const&... args) {
+  construct_each(alloc, to, size, [&](T* p, size_t) {
+    std::allocator_traits<Allocator>::construct(alloc, p, args...);
+  });
+}
+
+template <typename Allocator, typename T>
+void copy_elements(Allocator& alloc, T const* from, T* to, const size_t size) {
+  if constexpr (std::is_trivially_copyable_v<T>) {
+    copy_bytes(from, to, size);
+  } else {
+    construct_each(alloc, to, size, [&](T* p, size_t i) {
+      std::allocator_traits<Allocator>::construct(alloc, p, from[i]);
+    });
+  }
+}
+
+// Moves the elements to uninitialized memory, keeping the originals. Moves
+// when the move constructor is noexcept and copies otherwise, so a failure
+// leaves `from` intact.
+template <typename Allocator, typename T>
+void move_elements(Allocator& alloc, T* from, T* to, const size_t size) {
+  construct_each(alloc, to, size, [&](T* p, size_t i) {
+    std::allocator_traits<Allocator>::construct(
+        alloc, p, std::move_if_noexcept(from[i]));
+  });
+}
+
+// Moves the elements to uninitialized memory and destroys the originals.
+template <typename Allocator, typename T>
+void relocate_elements(Allocator& alloc, T* from, T* to, const size_t size) {
+  if constexpr (is_trivially_relocatable_v<T>) {
+    copy_bytes<T>(from, to, size);
+  } else {
+    move_elements(alloc, from, to, size);
+    remove_elements(alloc, from, size);
+  }
+}
+
+// Shifts possibly overlapping trivially relocatable elements.
+template <typename T>
+void shift_elements(T* from, T* to, const size_t size) {
+  if (size != 0) {
+    std::memmove(static_cast<void*>(to), static_cast<void const*>(from),
+                 sizeof(T) * size);
+  }
+}
+
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::ensure_capacity(size_t new_capacity) {
+  if constexpr (reallocates) {
+    if (data_ != nullptr && new_capacity != 0) {
+      data_ = alloc_.reallocate(data_, capacity_, new_capacity);
+      capacity_ = new_capacity;
+      return;
+    }
+  }
   T* new_data = nullptr;
   if (new_capacity != 0)
-    new_data = static_cast<T*>(operator new(sizeof(T) * new_capacity));
+    new_data = allocate(new_capacity);
   try {
-    copy_elements(data_, new_data, size_);
+    relocate_elements(alloc_, data_, new_data, size_);
   } catch (...) {
-    operator delete(new_data);
+    deallocate(new_data, new_capacity);
     throw;
   }
-  remove_elements(data_, size_);
-  operator delete(data_);
+  deallocate(data_, capacity_);
   data_ = new_data;
   capacity_ = new_capacity;
 }
 
-template <typename T>
-vector<T>::vector() : data_(nullptr), size_(0), capacity_(0) {}
+template <typename T, typename Allocator, typename Growth>
+T* vector<T, Allocator, Growth>::allocate(size_t n) {
+  return alloc_traits::allocate(alloc_, n);
+}
 
-template <typename T>
-vector<T>::vector(vector<T> const& other) : vector() {
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::deallocate(T* p, size_t n) {
+  if (p != nullptr) {
+    alloc_traits::deallocate(alloc_, p, n);
+  }
+}
+
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::swap_storage(vector& other) {
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+  std::swap(capacity_, other.capacity_);
+}
+
+template <typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::vector() : vector(Allocator()) {}
+
+template <typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::vector(Allocator const& alloc)
+    : data_(nullptr), size_(0), capacity_(0), alloc_(alloc) {}
+
+template <typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::vector(vector const& other)
+    : vector(other, alloc_traits::select_on_container_copy_construction(
+                        other.alloc_)) {}
+
+template <typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::vector(vector const& other,
+                                     Allocator const& alloc)
+    : vector(alloc) {
   if (other.size_ == 0)
     return;
-  T* new_data = static_cast<T*>(operator new(sizeof(T) * other.size_));
+  T* new_data = allocate(other.size_);
   try {
-    copy_elements(other.data_, new_data, other.size_);
+    copy_elements(alloc_, other.data_, new_data, other.size_);
   } catch (...) {
-    operator delete(new_data);
+    deallocate(new_data, other.size_);
     throw;
   }
   data_ = new_data;
   capacity_ = size_ = other.size_;
 }
 
-template <typename T>
-vector<T>& vector<T>::operator=(vector<T> const& other) {
-  if (this != &other) {
-    vector<T> new_vector(other);
-    swap(new_vector);
+template <typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>&
+vector<T, Allocator, Growth>::operator=(vector const& other) {
+  if (this == &other) {
+    return *this;
+  }
+  if constexpr (std::is_nothrow_copy_constructible_v<T> &&
+                std::is_nothrow_copy_assignable_v<T>) {
+    // the elements cannot fail to copy, so the buffer is reused when it is
+    // large enough and stays with this allocator; only handing the copy to
+    // the parallel pool may throw, which happens first, while the existing
+    // elements are untouched
+    bool same_allocator =
+        !alloc_traits::propagate_on_container_copy_assignment::value ||
+        alloc_ == other.alloc_;
+    if (same_allocator && other.size_ <= capacity_) {
+      size_t common = std::min(size_, other.size_);
+      if (other.size_ > size_) {
+        copy_elements(alloc_, other.data_ + size_, data_ + size_,
+                      other.size_ - size_);
+      } else {
+        remove_elements(alloc_, data_ + other.size_, size_ - other.size_);
+      }
+      std::copy_n(other.data_, common, data_);
+      size_ = other.size_;
+      return *this;
+    }
+  }
+  if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+    // the old elements are freed by the old allocator, which the copy takes
+    // in exchange
+    vector new_vector(other, other.alloc_);
+    swap_storage(new_vector);
+    std::swap(alloc_, new_vector.alloc_);
+  } else {
+    vector new_vector(other, alloc_);
+    swap_storage(new_vector);
   }
   return *this;
 }
 
-template <typename T>
-vector<T>::~vector() {
+template <typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::vector(vector&& other) noexcept
+    : data_(other.data_), size_(other.size_), capacity_(other.capacity_),
+      alloc_(std::move(other.alloc_)) {
+  other.data_ = nullptr;
+  other.size_ = other.capacity_ = 0;
+}
+
+template <typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>&
+vector<T, Allocator, Growth>::operator=(vector&& other) noexcept(
+    moves_storage) {
+  if (this == &other) {
+    return *this;
+  }
+  if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+    release();
+    alloc_ = std::move(other.alloc_);
+    swap_storage(other);
+  } else if (alloc_traits::is_always_equal::value || alloc_ == other.alloc_) {
+    release();
+    swap_storage(other);
+  } else {
+    // the buffer belongs to another allocator, so the elements move one by
+    // one
+    assign(std::make_move_iterator(other.begin()),
+           std::make_move_iterator(other.end()));
+  }
+  return *this;
+}
+
+template <typename T, typename Allocator, typename Growth>
+vector<T, Allocator, Growth>::~vector() {
+  release();
+}
+
+// destroys the elements and frees the buffer, leaving an empty vector
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::release() noexcept {
   clear();
-  operator delete(data_);
+  deallocate(data_, capacity_);
+  data_ = nullptr;
+  capacity_ = 0;
 }
 
-template <typename T>
-T& vector<T>::operator[](size_t i) {
+template <typename T, typename Allocator, typename Growth>
+Allocator vector<T, Allocator, Growth>::get_allocator() const {
+  return alloc_;
+}
+
+template <typename T, typename Allocator, typename Growth>
+T& vector<T, Allocator, Growth>::operator[](size_t i) {
   return data_[i];
 }
 
-template <typename T>
-T const& vector<T>::operator[](size_t i) const {
+template <typename T, typename Allocator, typename Growth>
+T const& vector<T, Allocator, Growth>::operator[](size_t i) const {
   return data_[i];
 }
 
-template <typename T>
-T* vector<T>::data() {
+template <typename T, typename Allocator, typename Growth>
+T* vector<T, Allocator, Growth>::data() {
   return data_;
 }
 
-template <typename T>
-T const* vector<T>::data() const {
+template <typename T, typename Allocator, typename Growth>
+T const* vector<T, Allocator, Growth>::data() const {
   return data_;
 }
 
-template <typename T>
-size_t vector<T>::size() const {
+template <typename T, typename Allocator, typename Growth>
+size_t vector<T, Allocator, Growth>::size() const {
   return size_;
 }
 
-template <typename T>
-T& vector<T>::front() {
+template <typename T, typename Allocator, typename Growth>
+T& vector<T, Allocator, Growth>::front() {
   return *data_;
 }
 
-template <typename T>
-T const& vector<T>::front() const {
+template <typename T, typename Allocator, typename Growth>
+T const& vector<T, Allocator, Growth>::front() const {
   return *data_;
 }
 
-template <typename T>
-T& vector<T>::back() {
+template <typename T, typename Allocator, typename Growth>
+T& vector<T, Allocator, Growth>::back() {
   return data_[size_ - 1];
 }
 
-template <typename T>
-T const& vector<T>::back() const {
+template <typename T, typename Allocator, typename Growth>
+T const& vector<T, Allocator, Growth>::back() const {
   return data_[size_ - 1];
 }
 
-template <typename T>
-void vector<T>::push_back(T const& element) {
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::push_back(T const& element) {
+  emplace_back(element);
+}
+
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::push_back(T&& element) {
+  emplace_back(std::move(element));
+}
+
+template <typename T, typename Allocator, typename Growth>
+template <typename... Args>
+T& vector<T, Allocator, Growth>::emplace_back(Args&&... args) {
   if (size_ != capacity_) {
-    new (data_ + size_) T(element);
+    alloc_traits::construct(alloc_, data_ + size_,
+                            std::forward<Args>(args)...);
+  } else if constexpr (reallocates) {
+    // the arguments may refer to elements, which move with the block, so the
+    // new one is made aside and then relocated
+    alignas(T) unsigned char value[sizeof(T)];
+    T* p = reinterpret_cast<T*>(value);
+    alloc_traits::construct(alloc_, p, std::forward<Args>(args)...);
+    try {
+      ensure_capacity(Growth::next(capacity_, size_ + 1, sizeof(T)));
+    } catch (...) {
+      alloc_traits::destroy(alloc_, p);
+      throw;
+    }
+    std::memcpy(static_cast<void*>(data_ + size_), value, sizeof(T));
   } else {
-    size_t new_capacity = 2 * size_ + 1;
-    T* new_data = static_cast<T*>(operator new(sizeof(T) * (new_capacity)));
+    size_t new_capacity = Growth::next(capacity_, size_ + 1, sizeof(T));
+    T* new_data = allocate(new_capacity);
+    // the arguments may refer to elements, so the new one is constructed
+    // before they are relocated
     try {
-      copy_elements(data_, new_data, size_, &element);
+      alloc_traits::construct(alloc_, new_data + size_,
+                              std::forward<Args>(args)...);
     } catch (...) {
-      operator delete(new_data);
+      deallocate(new_data, new_capacity);
       throw;
     }
-    remove_elements(data_, size_);
-    operator delete(data_);
+    try {
+      relocate_elements(alloc_, data_, new_data, size_);
+    } catch (...) {
+      alloc_traits::destroy(alloc_, new_data + size_);
+      deallocate(new_data, new_capacity);
+      throw;
+    }
+    deallocate(data_, capacity_);
     data_ = new_data;
     capacity_ = new_capacity;
   }
   ++size_;
+  return back();
 }
 
-template <typename T>
-void vector<T>::pop_back() {
-  data_[--size_].~T();
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::pop_back() {
+  alloc_traits::destroy(alloc_, data_ + --size_);
 }
 
-template <typename T>
-bool vector<T>::empty() const {
+template <typename T, typename Allocator, typename Growth>
+bool vector<T, Allocator, Growth>::empty() const {
   return size_ == 0;
 }
 
-template <typename T>
-size_t vector<T>::capacity() const {
+template <typename T, typename Allocator, typename Growth>
+size_t vector<T, Allocator, Growth>::capacity() const {
   return capacity_;
 }
 
-template <typename T>
-void vector<T>::reserve(size_t new_capacity) {
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::reserve(size_t new_capacity) {
   if (capacity_ < new_capacity) {
     ensure_capacity(new_capacity);
   }
 }
 
-template <typename T>
-void vector<T>::shrink_to_fit() {
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::shrink_to_fit() {
   if (capacity_ > size_) {
     ensure_capacity(size_);
   }
 }
 
-template <typename T>
-void vector<T>::clear() {
-  remove_elements(data_, size_);
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::resize(size_t n) {
+  if (n < size_) {
+    erase(begin() + n, end());
+  } else {
+    insert_n(
+        size_, n - size_,
+        [&](T* to, size_t first, size_t last) {
+          construct_elements(alloc_, to, last - first);
+        },
+        [](T*, size_t, size_t) {});
+  }
+}
+
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::resize(size_t n, T const& element) {
+  if (n < size_) {
+    erase(begin() + n, end());
+  } else {
+    insert(end(), n - size_, element);
+  }
+}
+
+// Trivial elements are left uninitialized, for the caller to fill, others
+// are default-initialized.
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::resize_default_init(size_t n) {
+  if (n < size_) {
+    erase(begin() + n, end());
+  } else {
+    insert_n(
+        size_, n - size_,
+        [&](T* to, size_t first, size_t last) {
+          if constexpr (!std::is_trivially_default_constructible_v<T>) {
+            construct_elements(alloc_, to, last - first);
+          }
+        },
+        [](T*, size_t, size_t) {});
+  }
+}
+
+template <typename T, typename Allocator, typename Growth>
+template <typename InputIt, typename>
+void vector<T, Allocator, Growth>::append(InputIt first, InputIt last) {
+  insert(end(), first, last);
+}
+
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::assign(size_t count, T const& element) {
+  // the element may be one of those destroyed
+  T value(element);
+  clear();
+  insert(end(), count, value);
+}
+
+template <typename T, typename Allocator, typename Growth>
+template <typename InputIt, typename>
+void vector<T, Allocator, Growth>::assign(InputIt first, InputIt last) {
+  clear();
+  insert(end(), first, last);
+}
+
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::clear() {
+  remove_elements(alloc_, data_, size_);
   size_ = 0;
 }
 
-template <typename T>
-void vector<T>::swap(vector<T>& other) {
-  std::swap(data_, other.data_);
-  std::swap(size_, other.size_);
-  std::swap(capacity_, other.capacity_);
+template <typename T, typename Allocator, typename Growth>
+void vector<T, Allocator, Growth>::swap(vector& other) noexcept {
+  swap_storage(other);
+  if constexpr (alloc_traits::propagate_on_container_swap::value) {
+    std::swap(alloc_, other.alloc_);
+  }
 }
 
-template <typename T>
-typename vector<T>::iterator vector<T>::begin() {
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator
+vector<T, Allocator, Growth>::begin() {
   return data_;
 }
 
-template <typename T>
-typename vector<T>::iterator vector<T>::end() {
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator
+vector<T, Allocator, Growth>::end() {
   return begin() + size_;
 }
 
-template <typename T>
-typename vector<T>::const_iterator vector<T>::begin() const {
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::const_iterator
+vector<T, Allocator, Growth>::begin() const {
   return data_;
 }
 
-template <typename T>
-typename vector<T>::const_iterator vector<T>::end() const {
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::const_iterator
+vector<T, Allocator, Growth>::end() const {
   return begin() + size_;
 }
 
-template <typename T>
-typename vector<T>::iterator vector<T>::insert(vector<T>::const_iterator pos,
-                                               T const& element) {
-  ptrdiff_t pos_ind = pos - begin();
-  push_back(element);
-  for (ptrdiff_t i = end() - begin() - 1; i > pos_ind; --i) {
-    std::swap(data_[i], data_[i - 1]);
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator
+vector<T, Allocator, Growth>::insert(const_iterator pos, T const& element) {
+  return emplace(pos, element);
+}
+
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator
+vector<T, Allocator, Growth>::insert(const_iterator pos, T&& element) {
+  return emplace(pos, std::move(element));
+}
+
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator
+vector<T, Allocator, Growth>::insert(const_iterator pos, size_t count,
+                                     T const& element) {
+  // the element may be one of those shifted
+  T value(element);
+  return insert_n(
+      pos - begin(), count,
+      [&](T* to, size_t first, size_t last) {
+        construct_elements(alloc_, to, last - first, value);
+      },
+      [&](T* to, size_t first, size_t last) {
+        std::fill_n(to, last - first, value);
+      });
+}
+
+template <typename T, typename Allocator, typename Growth>
+template <typename InputIt, typename>
+typename vector<T, Allocator, Growth>::iterator
+vector<T, Allocator, Growth>::insert(const_iterator pos, InputIt first,
+                                     InputIt last) {
+  using category = typename std::iterator_traits<InputIt>::iterator_category;
+  size_t pos_ind = pos - begin();
+  if constexpr (!std::is_base_of_v<std::forward_iterator_tag, category>) {
+    // a single pass range is appended and then rotated into place
+    size_t old_size = size_;
+    try {
+      for (; first != last; ++first) {
+        emplace_back(*first);
+      }
+    } catch (...) {
+      while (size_ != old_size) {
+        pop_back();
+      }
+      throw;
+    }
+    std::rotate(begin() + pos_ind, begin() + old_size, end());
+    return begin() + pos_ind;
+  } else {
+    return insert_n(
+        pos_ind, std::distance(first, last),
+        [&](T* to, size_t from, size_t until) {
+          if constexpr (std::is_same_v<InputIt, T*> ||
+                        std::is_same_v<InputIt, T const*>) {
+            // copied in one go when trivially copyable
+            copy_elements(alloc_, first + from, to, until - from);
+          } else {
+            InputIt it = std::next(first, from);
+            size_t ind = 0;
+            try {
+              for (; ind < until - from; ++ind, ++it) {
+                alloc_traits::construct(alloc_, to + ind, *it);
+              }
+            } catch (...) {
+              remove_elements(alloc_, to, ind);
+              throw;
+            }
+          }
+        },
+        [&](T* to, size_t from, size_t until) {
+          std::copy_n(std::next(first, from), until - from, to);
+        });
   }
-  return begin() + pos_ind;
 }
 
-template <typename T>
-typename vector<T>::iterator vector<T>::erase(vector<T>::const_iterator pos) {
-  return erase(pos, pos + 1);
+template <typename T, typename Allocator, typename Growth>
+template <typename... Args>
+typename vector<T, Allocator, Growth>::iterator
+vector<T, Allocator, Growth>::emplace(const_iterator pos, Args&&... args) {
+  size_t pos_ind = pos - begin();
+  if (pos_ind == size_) {
+    emplace_back(std::forward<Args>(args)...);
+    return begin() + pos_ind;
+  }
+  // the arguments may refer to elements, which are shifted before the new
+  // one takes its place
+  T value(std::forward<Args>(args)...);
+  return insert_n(
+      pos_ind, 1,
+      [&](T* to, size_t first, size_t last) {
+        if (first != last) {
+          alloc_traits::construct(alloc_, to, std::move(value));
+        }
+      },
+      [&](T* to, size_t first, size_t last) {
+        if (first != last) {
+          *to = std::move(value);
+        }
+      });
 }
 
-template <typename T>
-typename vector<T>::iterator vector<T>::erase(vector<T>::const_iterator first,
-                                              vector<T>::const_iterator last) {
-  ptrdiff_t first_ind = first - begin();
-  ptrdiff_t last_ind = last - begin();
-  for (ptrdiff_t i = 0; i < end() - last; ++i) {
-    std::swap(data_[first_ind + i], data_[last_ind + i]);
+// Inserts count elements before pos. construct(to, first, last) constructs
+// the new elements [first, last) in uninitialized memory at to, destroying
+// what it made if it throws; assign(to, first, last) assigns them to
+// existing elements. With enough capacity the tail is shifted by memmove
+// for trivially relocatable types and by moves otherwise; on reallocation
+// the new elements are constructed in the new buffer and the old ones are
+// relocated around them.
+template <typename T, typename Allocator, typename Growth>
+template <typename Construct, typename Assign>
+typename vector<T, Allocator, Growth>::iterator
+vector<T, Allocator, Growth>::insert_n(size_t pos, size_t count,
+                                       Construct construct, Assign assign) {
+  if (count == 0) {
+    return begin() + pos;
+  }
+  if constexpr (reallocates) {
+    if (capacity_ - size_ < count) {
+      // the block is resized and the tail shifted within it
+      ensure_capacity(Growth::next(capacity_, size_ + count, sizeof(T)));
+    }
   }
-  for (ptrdiff_t i = 0; i < last_ind - first_ind; ++i) {
-    pop_back();
+  size_t after = size_ - pos;
+  if (capacity_ - size_ < count) {
+    size_t new_capacity = Growth::next(capacity_, size_ + count, sizeof(T));
+    T* new_data = allocate(new_capacity);
+    try {
+      construct(new_data + pos, 0, count);
+    } catch (...) {
+      deallocate(new_data, new_capacity);
+      throw;
+    }
+    if constexpr (is_trivially_relocatable_v<T>) {
+      relocate_elements(alloc_, data_, new_data, pos);
+      relocate_elements(alloc_, data_ + pos, new_data + pos + count, after);
+    } else {
+      try {
+        move_elements(alloc_, data_, new_data, pos);
+        try {
+          move_elements(alloc_, data_ + pos, new_data + pos + count, after);
+        } catch (...) {
+          remove_elements(alloc_, new_data, pos);
+          throw;
+        }
+      } catch (...) {
+        remove_elements(alloc_, new_data + pos, count);
+        deallocate(new_data, new_capacity);
+        throw;
+      }
+      remove_elements(alloc_, data_, size_);
+    }
+    deallocate(data_, capacity_);
+    data_ = new_data;
+    capacity_ = new_capacity;
+    size_ += count;
+  } else if constexpr (is_trivially_relocatable_v<T>) {
+    T* p = data_ + pos;
+    shift_elements(p, p + count, after);
+    try {
+      construct(p, 0, count);
+    } catch (...) {
+      shift_elements(p + count, p, after);
+      throw;
+    }
+    size_ += count;
+  } else {
+    T* p = data_ + pos;
+    T* e = data_ + size_;
+    if (after > count) {
+      // the last count elements move to uninitialized memory, the rest of
+      // the tail moves over existing elements
+      move_elements(alloc_, e - count, e, count);
+      size_ += count;
+      std::move_backward(p, e - count, e);
+      assign(p, 0, count);
+    } else {
+      // the new elements past the end are constructed, the tail moves after
+      // them and the rest of the new elements replace it
+      construct(e, after, count);
+      try {
+        move_elements(alloc_, p, e + (count - after), after);
+      } catch (...) {
+        remove_elements(alloc_, e, count - after);
+        throw;
+      }
+      size_ += count;
+      assign(p, 0, after);
+    }
+  }
+  return begin() + pos;
+}
+
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator
+vector<T, Allocator, Growth>::erase(const_iterator pos) {
+  return erase(pos, pos + 1);
+}
+
+template <typename T, typename Allocator, typename Growth>
+typename vector<T, Allocator, Growth>::iterator
+vector<T, Allocator, Growth>::erase(const_iterator first, const_iterator last) {
+  size_t first_ind = first - begin();
+  size_t count = last - first;
+  T* p = data_ + first_ind;
+  if constexpr (is_trivially_relocatable_v<T>) {
+    remove_elements(alloc_, p, count);
+    shift_elements(p + count, p, size_ - first_ind - count);
+  } else {
+    std::move(p + count, data_ + size_, p);
+    remove_elements(alloc_, data_ + size_ - count, count);
   }
+  size_ -= count;
   return begin() + first_ind;
 }